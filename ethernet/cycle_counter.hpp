@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ * @file    cycle_counter.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the cycle counter of core: the cycles of
+ *          profiler and the seed of TCP initial sequence, it does not
+ *          depend on ENC28J60_INSTRUMENTATION.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CYCLE_COUNTER_HPP
+#define __CYCLE_COUNTER_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/**
+ * @brief Source of cycles: DWT CYCCNT of Cortex-M3 on target (IAR build),
+ *        software counter advanced by simulation on host (also on ARM
+ *        Linux, where DWT is not accessible)
+ */
+class CycleCounter {
+  public:
+#if defined(__ICCARM__)
+    /**
+     * @brief Start the counter, the counter is not cleared: the users take
+     *        differences of cycles, so the second call does not break them
+     */
+    static void enable()
+    {
+        // DEMCR.TRCENA, DWT_CTRL.CYCCNTENA
+        *reinterpret_cast<volatile uint32_t*>(DEMCR_ADDRESS) |= 0x01000000;
+        *reinterpret_cast<volatile uint32_t*>(DWT_CTRL_ADDRESS) |= 0x00000001;
+    }
+
+    static uint32_t now()
+    {
+        return *reinterpret_cast<volatile uint32_t*>(DWT_CYCCNT_ADDRESS);
+    }
+
+  private:
+    static constexpr uint32_t DEMCR_ADDRESS = 0xE000EDFC;
+    static constexpr uint32_t DWT_CTRL_ADDRESS = 0xE0001000;
+    static constexpr uint32_t DWT_CYCCNT_ADDRESS = 0xE0001004;
+#else
+    static void enable() {}
+
+    static uint32_t now()
+    {
+        return counter();
+    }
+
+    /**
+     * @brief Advance the counter (the host model of time)
+     * @param [in] cycles - number of cycles
+     */
+    static void advance(uint32_t cycles)
+    {
+        counter() += cycles;
+    }
+
+  private:
+    static uint32_t& counter()
+    {
+        static uint32_t cycles = 0;
+        return cycles;
+    }
+#endif
+};
+
+#endif
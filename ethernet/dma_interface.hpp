@@ -0,0 +1,80 @@
+/**
+ ******************************************************************************
+ * @file    dma_interface.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the bulk transfer (DMA) interface for the
+ *          ENC28J60 buffer memory bursts.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DMA_INTERFACE_HPP
+#define __DMA_INTERFACE_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Interface of the bulk transfer channel.
+ *        Transfer runs in the background, completion is reported
+ *        by callback (from interrupt) or polled with isBusy().
+ */
+class DmaInterface {
+  public:
+    typedef void (*Callback)(void*);
+
+    virtual ~DmaInterface() = default;
+
+    /**
+     * @brief Start full duplex transfer, chip select is held by caller
+     * @param [in] txData - data for transmit, nullptr - send dummy bytes
+     * @param [out] rxData - buffer for receive, nullptr - discard bytes
+     * @param [in] len - length of transfer in bytes
+     */
+    virtual void startTransfer(const uint8_t* txData,
+        uint8_t* rxData,
+        size_t len) = 0;
+
+    virtual bool isBusy() const = 0;
+
+    /**
+     * @brief Set function calling on complete transfer
+     * @param [in] callback - function, nullptr - disable
+     * @param [in] context - argument of function
+     */
+    void setCallback(Callback callback, void* context)
+    {
+        _callback = callback;
+        _context = context;
+    }
+
+    void waitComplete() const
+    {
+        while(isBusy()) {
+        }
+    }
+
+  protected:
+    DmaInterface() : _callback(nullptr), _context(nullptr) {}
+
+    void complete()
+    {
+        if(_callback != nullptr) {
+            _callback(_context);
+        }
+    }
+
+  private:
+    Callback _callback;
+    void* _context;
+};
+
+#endif
@@ -16,38 +16,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include "enc28j60.hpp"
 
-/**
- * @brief Constructor
- * @param [in] port - virtual port (SPI)
- */
-Enc28j60::Enc28j60(const SpiInterface::Config* interfaceConfig,
-    const Config* config) :
-    _interface(interfaceConfig),
-    _enc28j60Bank(0),
-    _nextPacketPtr(RXSTART_INIT),
-    _tcpPort(0),
-    _buffer(nullptr),
-    _bufSize(0),
-    _isError(false)
-{
-    writeOp(ENC28J60_SOFT_RESET, 0, ENC28J60_SOFT_RESET);
-    _interface.delayUs(100);
-
-    // Rx start
-    writeReg(ERXSTL, RXSTART_INIT & 0xFF);
-    writeReg(ERXSTH, RXSTART_INIT >> 8);
-    // set receive pointer address
-    writeReg(ERXRDPTL, RXSTART_INIT & 0xFF);
-    writeReg(ERXRDPTH, RXSTART_INIT >> 8);
-    // RX end
-    writeReg(ERXNDL, RXSTOP_INIT & 0xFF);
-    writeReg(ERXNDH, RXSTOP_INIT >> 8);
-    // TX start
-    writeReg(ETXSTL, TXSTART_INIT & 0xFF);
-    writeReg(ETXSTH, TXSTART_INIT >> 8);
-    // TX end
-    writeReg(ETXNDL, TXSTOP_INIT & 0xFF);
-    writeReg(ETXNDH, TXSTOP_INIT >> 8);
+/// Initialization of registers, sorted by bank for minimum bank switches
+/// (the buffer boundaries of bank 0 are written before it by configuration)
+constexpr Enc28j60::RegValue Enc28j60::INIT_SCRIPT[] = {
     // do bank 1 stuff, packet filter:
     // For broadcast packets we allow only ARP packtets
     // All other packets should be unicast only for our mac (MAADR)
@@ -58,70 +29,176 @@ Enc28j60::Enc28j60(const SpiInterface::Config* interfaceConfig,
     // 06 08 -- ff ff ff ff ff ff -> ip checksum for theses bytes=f7f9
     // in binary these poitions are:11 0000 0011 1111
     // This is hex 303F->EPMM0=0x3F,EPMM1=0x30
-    writeReg(ERXFCON, ERXFCON_UCEN | ERXFCON_CRCEN | ERXFCON_PMEN);
-    writeReg(EPMM0, 0x3F);
-    writeReg(EPMM1, 0x30);
-
-    writeReg(EPMCSL, 0xF9);
-    writeReg(EPMCSH, 0xF7);
+    { ERXFCON, ERXFCON_UCEN | ERXFCON_CRCEN | ERXFCON_PMEN },
+    { EPMM0, 0x3F },
+    { EPMM1, 0x30 },
+    { EPMCSL, 0xF9 },
+    { EPMCSH, 0xF7 },
 
     // do bank 2 stuff
     // enable MAC receive
-    writeReg(MACON1, MACON1_MARXEN | MACON1_TXPAUS | MACON1_RXPAUS);
+    { MACON1, MACON1_MARXEN | MACON1_TXPAUS | MACON1_RXPAUS },
     // bring MAC out of reset
-    writeReg(MACON2, 0x00);
+    { MACON2, 0x00 },
+    // Set the maximum packet size which the controller will accept
+    // Do not send packets longer than MAX_FRAMELEN:
+    { MAMXFLL, MAX_FRAMELEN & 0xFF },
+    { MAMXFLH, MAX_FRAMELEN >> 8 }
+};
+
+/// MAC timing of half-duplex (bank 2)
+constexpr Enc28j60::RegValue Enc28j60::HALF_DUPLEX_SCRIPT[] = {
     // enable automatic padding to 60bytes and CRC operations
-    writeOp(ENC28J60_BIT_FIELD_SET,
-        MACON3,
-        MACON3_PADCFG0 | MACON3_TXCRCEN | MACON3_FRMLNEN);
+    { MACON3, MACON3_PADCFG0 | MACON3_TXCRCEN | MACON3_FRMLNEN },
     // set inter-frame gap (non-back-to-back)
-    writeReg(MAIPGL, 0x12);
-    writeReg(MAIPGH, 0x0C);
+    { MAIPGL, 0x12 },
+    { MAIPGH, 0x0C },
     // set inter-frame gap (back-to-back)
-    writeReg(MABBIPG, 0x12);
-    // Set the maximum packet size which the controller will accept
-    // Do not send packets longer than MAX_FRAMELEN:
-    writeReg(MAMXFLL, MAX_FRAMELEN & 0xFF);
-    writeReg(MAMXFLH, MAX_FRAMELEN >> 8);
+    { MABBIPG, 0x12 }
+};
+
+/// MAC timing of full-duplex (bank 2), MAIPGH is not used
+constexpr Enc28j60::RegValue Enc28j60::FULL_DUPLEX_SCRIPT[] = {
+    // enable automatic padding to 60bytes, CRC operations and full-duplex
+    { MACON3,
+        MACON3_PADCFG0 | MACON3_TXCRCEN | MACON3_FRMLNEN | MACON3_FULDPX },
+    // set inter-frame gap (non-back-to-back)
+    { MAIPGL, 0x12 },
+    // set inter-frame gap (back-to-back)
+    { MABBIPG, 0x15 }
+};
+
+/**
+ * @brief Constructor
+ * @param [in] port - virtual port (SPI)
+ */
+Enc28j60::Enc28j60(const SpiInterface::Config* interfaceConfig,
+    const Config* config) :
+    _interface(interfaceConfig),
+    _dma(config->dma),
+    _enc28j60Bank(0),
+    _nextPacketPtr(RXSTART_INIT),
+    _pendingPackets(0),
+    _rxDataPtr(RXSTART_INIT),
+    _rxLen(0),
+    _rxFetched(0),
+    _isPacketHeld(false),
+    _rxStop(0),
+    _txStart(0),
+    _txSlots(0),
+    _txSlotSize(0),
+    _txHead(0),
+    _txCount(0),
+    _isTransmit(false),
+    _statistics(),
+    _isChecksumOffload(false),
+    _duplex(Duplex::HALF),
+    _isRxPending(false),
+    _isBurst(false),
+    _config(*config)
+{
+    if(_dma != nullptr) {
+        _dma->setCallback(&Enc28j60::completeBurst, this);
+    }
+    reset();
+}
+
+/**
+ * @brief Soft reset of ENC28J60 and configuration of constructor, e.g.
+ *        after change of SPI clock (a test on wrong clock may corrupt
+ *        registers). The frames in buffers and multicast groups are lost.
+ */
+void Enc28j60::reset()
+{
+    const Config* config = &_config;
+
+    _nextPacketPtr = RXSTART_INIT;
+    _pendingPackets = 0;
+    _rxDataPtr = RXSTART_INIT;
+    _rxLen = 0;
+    _rxFetched = 0;
+    _isPacketHeld = false;
+    _txHead = 0;
+    _txCount = 0;
+    _isTransmit = false;
+    _isChecksumOffload = false;
+    _isRxPending = false;
+
+    writeOp(ENC28J60_SOFT_RESET, 0, ENC28J60_SOFT_RESET);
+    _interface.delayUs(100);
+    resetShadow();
+
+    // wrong partition is replaced by default partition
+    static_assert(isValidPartition(TX_SLOTS, TX_SLOT_SIZE),
+        "Default partition must be valid");
+    if(!initPartition(config->txSlots, config->txSlotSize)) {
+        ++_statistics.configErrors;
+        initPartition(TX_SLOTS, TX_SLOT_SIZE);
+    }
+    resetTelemetry();
+
+    // do bank 0 stuff
+    initRing();
+    // TX start
+    writeReg(ETXSTL, _txStart & 0xFF);
+    writeReg(ETXSTH, _txStart >> 8);
+
+    constexpr size_t INIT_SCRIPT_SIZE =
+        sizeof(INIT_SCRIPT) / sizeof(INIT_SCRIPT[0]);
+    static_assert(isSortedByBank(INIT_SCRIPT, INIT_SCRIPT_SIZE),
+        "Init script must be sorted by bank");
+    writeRegs(INIT_SCRIPT, INIT_SCRIPT_SIZE);
+
+    // PHY and MAC must have the same duplex, ENC28J60 has not
+    // auto-negotiation: the duplex is set by hand to match the port
+    // of switch (PHSTAT1 only tells that PHY is able of both duplexes)
+    _duplex = config->duplex;
+    if(Duplex::FULL == _duplex) {
+        writeRegs(FULL_DUPLEX_SCRIPT,
+            sizeof(FULL_DUPLEX_SCRIPT) / sizeof(FULL_DUPLEX_SCRIPT[0]));
+        phyWrite(PHCON1, PHCON1_PDPXMD);
+    }
+    else {
+        writeRegs(HALF_DUPLEX_SCRIPT,
+            sizeof(HALF_DUPLEX_SCRIPT) / sizeof(HALF_DUPLEX_SCRIPT[0]));
+        phyWrite(PHCON1, 0x0000);
+        // no loopback of transmitted frames (MII registers of bank 2 and 3)
+        phyWrite(PHCON2, PHCON2_HDLDIS);
+    }
+    if(getDuplex() != _duplex) {
+        ++_statistics.configErrors;
+    }
+
     // do bank 3 stuff
     // write MAC address
     // NOTE: MAC address in ENC28J60 is byte-backward
-    writeReg(MAADR5, config->macAddr[0]);
-    writeReg(MAADR4, config->macAddr[1]);
-    writeReg(MAADR3, config->macAddr[2]);
-    writeReg(MAADR2, config->macAddr[3]);
-    writeReg(MAADR1, config->macAddr[4]);
-    writeReg(MAADR0, config->macAddr[5]);
-    // no loopback of transmitted frames
-    phyWrite(PHCON2, PHCON2_HDLDIS);
-    // switch to bank 0
-    setBank(ECON1);
-    // enable interrutps
-    writeOp(ENC28J60_BIT_FIELD_SET, EIE, EIE_INTIE | EIE_PKTIE);
+    const RegValue macScript[] = { { MAADR5, config->macAddr[0] },
+        { MAADR4, config->macAddr[1] },
+        { MAADR3, config->macAddr[2] },
+        { MAADR2, config->macAddr[3] },
+        { MAADR1, config->macAddr[4] },
+        { MAADR0, config->macAddr[5] } };
+    writeRegs(macScript, sizeof(macScript) / sizeof(macScript[0]));
+
+    // enable interrutps (the errors are recovered by receive)
+    setBits(EIE, EIE_INTIE | EIE_PKTIE | EIE_RXERIE | EIE_TXERIE);
     // enable packet reception
-    writeOp(ENC28J60_BIT_FIELD_SET, ECON1, ECON1_RXEN);
+    setBits(ECON1, ECON1_RXEN);
 
     initPhy();
 
-    memcpy(_macAddr, config->macAddr, MAC_ADDR_SIZE);
-    memcpy(_ipAddr, config->ipAddr, IP_ADDR_SIZE);
-
-    if(_bufSize > MAX_FRAMELEN) {
-        _bufSize = MAX_FRAMELEN;
+    // the offload is used only if its result matches software checksum
+    if(config->checksumOffload) {
+        _isChecksumOffload = testChecksumOffload();
     }
 
-    // Create memory
-    _buffer = ::new uint8_t[config->sizeBuf];
+    memset(_hashTable, 0, HASH_TABLE_SIZE);
+    memcpy(_macAddr, config->macAddr, MAC_ADDR_SIZE);
 
-    // Attacgh interrupt, calling update
+    // Attacgh interrupt, calling update (it only records event for poll)
     _interface.attach(this);
 }
 
-Enc28j60::~Enc28j60()
-{
-    ::delete[] _buffer;
-}
-
 void Enc28j60::initPhy()
 {
     /* Magjack leds configuration, see enc28j60 datasheet, page 11 */
@@ -155,6 +232,11 @@ void Enc28j60::initPhy()
 
 uint8_t Enc28j60::readReg(uint8_t address)
 {
+    // write-mostly registers are read from shadow
+    const int index = shadowIndex(address);
+    if(index >= 0) {
+        return _shadow[index];
+    }
     // set the bank
     setBank(address);
     // do the read
@@ -163,24 +245,136 @@ uint8_t Enc28j60::readReg(uint8_t address)
 
 void Enc28j60::writeReg(uint8_t address, uint8_t data)
 {
+    // skip write of the same value into write-mostly register
+    const int index = shadowIndex(address);
+    if(index >= 0) {
+        if(_shadow[index] == data) {
+            return;
+        }
+        _shadow[index] = data;
+    }
     // set the bank
     setBank(address);
     // do the write
     writeOp(ENC28J60_WRITE_CTRL_REG, address, data);
 }
 
+/**
+ * @brief Batch write of registers, the bank is switched only between
+ *        groups of registers of the same bank
+ * @param [in] script - registers and values
+ * @param [in] size - number of registers
+ */
+void Enc28j60::writeRegs(const RegValue* script, size_t size)
+{
+    for(size_t i = 0; i < size; ++i) {
+        writeReg(script[i].address, script[i].data);
+    }
+}
+
+/**
+ * @brief Bit field set of ETH register (not for MAC and MII registers)
+ * @param [in] address - register
+ * @param [in] mask - bits for set
+ */
+void Enc28j60::setBits(uint8_t address, uint8_t mask)
+{
+    const int index = shadowIndex(address);
+    if(index >= 0) {
+        if((_shadow[index] & mask) == mask) {
+            return;
+        }
+        _shadow[index] |= mask;
+    }
+    setBank(address);
+    writeOp(ENC28J60_BIT_FIELD_SET, address, mask);
+}
+
+/**
+ * @brief Bit field clear of ETH register (not for MAC and MII registers)
+ * @param [in] address - register
+ * @param [in] mask - bits for clear
+ */
+void Enc28j60::clearBits(uint8_t address, uint8_t mask)
+{
+    const int index = shadowIndex(address);
+    if(index >= 0) {
+        if((_shadow[index] & mask) == 0) {
+            return;
+        }
+        _shadow[index] &= ~mask;
+    }
+    setBank(address);
+    writeOp(ENC28J60_BIT_FIELD_CLR, address, mask);
+}
+
 void Enc28j60::setBank(uint8_t address)
 {
+    // registers of all banks do not need the bank
+    if((address & ADDR_MASK) >= EIE) {
+        return;
+    }
+
     // set the bank (if needed)
-    if((address & BANK_MASK) != _enc28j60Bank) {
-        writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, (ECON1_BSEL1 | ECON1_BSEL0));
-        writeOp(ENC28J60_BIT_FIELD_SET, ECON1, (address & BANK_MASK) >> 5);
-        _enc28j60Bank = (address & BANK_MASK);
+    const uint8_t bank = (address & BANK_MASK);
+    if(bank != _enc28j60Bank) {
+        _profiler.bankSwitch();
+        // only the changed bits of BSEL are written,
+        // that is one operation for the most of switches
+        const uint8_t newBits = bank >> 5;
+        const uint8_t oldBits = _enc28j60Bank >> 5;
+        if(oldBits & ~newBits) {
+            writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, oldBits & ~newBits);
+        }
+        if(newBits & ~oldBits) {
+            writeOp(ENC28J60_BIT_FIELD_SET, ECON1, newBits & ~oldBits);
+        }
+        _enc28j60Bank = bank;
     }
 }
 
+/**
+ * @brief Index of write-mostly register in shadow
+ * @param [in] address - register
+ * @retval index, -1 if register has not shadow
+ */
+int Enc28j60::shadowIndex(uint8_t address)
+{
+    switch(address) {
+        case EIE:
+            return SHADOW_EIE;
+        case ERXFCON:
+            return SHADOW_ERXFCON;
+        case MACON1:
+            return SHADOW_MACON1;
+        case MACON2:
+            return SHADOW_MACON2;
+        case MACON3:
+            return SHADOW_MACON3;
+        case MACON4:
+            return SHADOW_MACON4;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Set shadow of registers to values after reset (see datasheet)
+ */
+void Enc28j60::resetShadow()
+{
+    _enc28j60Bank = 0;
+    _shadow[SHADOW_EIE] = 0x00;
+    _shadow[SHADOW_ERXFCON] = ERXFCON_UCEN | ERXFCON_CRCEN | ERXFCON_BCEN;
+    _shadow[SHADOW_MACON1] = 0x00;
+    _shadow[SHADOW_MACON2] = MACON2_MARST;
+    _shadow[SHADOW_MACON3] = 0x00;
+    _shadow[SHADOW_MACON4] = 0x00;
+}
+
 void Enc28j60::writeOp(uint8_t oper, uint8_t address, uint8_t data)
 {
+    _profiler.spiTransaction();
     _interface.setSelect(true);
     _interface.sendByte(oper | (address & ADDR_MASK));
     _interface.sendByte(data);
@@ -189,6 +383,7 @@ void Enc28j60::writeOp(uint8_t oper, uint8_t address, uint8_t data)
 
 uint8_t Enc28j60::readOp(uint8_t oper, uint8_t address)
 {
+    _profiler.spiTransaction();
     _interface.setSelect(true);
     _interface.sendByte(oper | (address & ADDR_MASK));
     uint8_t data = _interface.getByte();
@@ -203,26 +398,87 @@ uint8_t Enc28j60::readOp(uint8_t oper, uint8_t address)
 
 void Enc28j60::writeBuffer(const uint8_t* data, size_t len)
 {
+    _profiler.spiTransaction();
     _interface.setSelect(true);
     _interface.sendByte(ENC28J60_WRITE_BUF_MEM);
+    transmitBurst(data, len);
+}
+
+void Enc28j60::readBuffer(uint8_t* data, size_t len)
+{
+    _profiler.spiTransaction();
+    _interface.setSelect(true);
+    _interface.sendByte(ENC28J60_READ_BUF_MEM);
+    receiveBurst(data, len);
+}
+
+/**
+ * @brief Transmit bytes of opened buffer memory operation and close it
+ * @param [in] data - pointer on data
+ * @param [in] len - length of data
+ */
+void Enc28j60::transmitBurst(const uint8_t* data, size_t len)
+{
+    if((_dma != nullptr) && (len >= DMA_MIN_TRANSFER)) {
+        _isBurst = true;
+        _dma->startTransfer(data, nullptr, len);
+        waitBurst();
+        return;
+    }
+
     for(size_t i = 0; i < len; ++i) {
         _interface.sendByte(*data++);
     }
     _interface.setSelect(false);
 }
 
-void Enc28j60::readBuffer(uint8_t* data, size_t len)
+/**
+ * @brief Receive bytes of opened buffer memory operation and close it
+ * @param [out] data - pointer where data should be stored
+ * @param [in] len - length of data
+ */
+void Enc28j60::receiveBurst(uint8_t* data, size_t len)
 {
-    _interface.setSelect(true);
-    _interface.sendByte(ENC28J60_READ_BUF_MEM);
+    if((_dma != nullptr) && (len >= DMA_MIN_TRANSFER)) {
+        _isBurst = true;
+        _dma->startTransfer(nullptr, data, len);
+        waitBurst();
+        return;
+    }
 
     for(size_t i = 0; i < len; ++i) {
         *data++ = _interface.getByte();
     }
-
     _interface.setSelect(false);
 }
 
+/**
+ * @brief Wait for end of DMA burst. The time is given to the idle
+ *        function of configuration, without it DMA is polled.
+ */
+void Enc28j60::waitBurst()
+{
+    if(nullptr == _config.idle) {
+        _dma->waitComplete();
+        return;
+    }
+    while(_isBurst) {
+        _config.idle(_config.idleContext);
+    }
+}
+
+/**
+ * @brief Callback of complete DMA burst (from interrupt): the buffer
+ *        memory operation is closed by chip select
+ * @param [in] context - pointer on driver
+ */
+void Enc28j60::completeBurst(void* context)
+{
+    Enc28j60* enc28j60 = static_cast<Enc28j60*>(context);
+    enc28j60->_interface.setSelect(false);
+    enc28j60->_isBurst = false;
+}
+
 void Enc28j60::phyWrite(uint8_t address, uint16_t data)
 {
     // set the PHY register address
@@ -236,37 +492,148 @@ void Enc28j60::phyWrite(uint8_t address, uint16_t data)
     }
 }
 
+uint16_t Enc28j60::phyRead(uint8_t address)
+{
+    // set the PHY register address
+    writeReg(MIREGADR, address);
+    // start the PHY read
+    writeReg(MICMD, MICMD_MIIRD);
+    // wait until the PHY read completes
+    while(readReg(MISTAT) & MISTAT_BUSY) {
+        _interface.delayUs(1);
+    }
+    writeReg(MICMD, 0x00);
+    // read the PHY data
+    return readReg(MIRDL) | (readReg(MIRDH) << 8);
+}
+
+/**
+ * @brief Current duplex of PHY
+ * @retval duplex
+ */
+Enc28j60::Duplex Enc28j60::getDuplex()
+{
+    return (phyRead(PHSTAT2) & PHSTAT2_DPXSTAT) ? Duplex::FULL : Duplex::HALF;
+}
+
+/**
+ * @brief Link status of PHY
+ * @retval true - link is up
+ */
+bool Enc28j60::isLinkUp()
+{
+    return (phyRead(PHSTAT2) & PHSTAT2_LSTAT) != 0;
+}
+
+/**
+ * @brief Check SPI link: revision ID and write/read back of SRAM pattern.
+ *        The pattern is written into first TX slot, so the test is called
+ *        before any transmit (on selection of SPI clock).
+ * @retval true - link is reliable
+ */
+bool Enc28j60::selfTest()
+{
+    // the bank bits may be corrupted by previous test on wrong clock
+    writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, (ECON1_BSEL1 | ECON1_BSEL0));
+    _enc28j60Bank = 0;
+
+    const uint8_t revision = readReg(EREVID);
+    if((0x00 == revision) || (0xFF == revision)) {
+        return false;
+    }
+
+    uint8_t pattern[SELF_TEST_SIZE];
+    for(size_t i = 0; i < SELF_TEST_SIZE; ++i) {
+        // both levels of each bit and the bit edges
+        pattern[i] = (i & 0x01) ? (0x55 ^ i) : (0xAA ^ i);
+    }
+
+    const size_t start = txSlotStart(0);
+    writeReg(EWRPTL, start & 0xFF);
+    writeReg(EWRPTH, start >> 8);
+    writeBuffer(pattern, SELF_TEST_SIZE);
+
+    uint8_t readback[SELF_TEST_SIZE];
+    writeReg(ERDPTL, start & 0xFF);
+    writeReg(ERDPTH, start >> 8);
+    readBuffer(readback, SELF_TEST_SIZE);
+
+    return 0 == memcmp(pattern, readback, SELF_TEST_SIZE);
+}
+
 /**
- * @brief Gets a packet from the network receive buffer, if one is available
+ * @brief Gets a packet from the network receive buffer, if one is available.
+ *        Only the head of packet (HEAD_SIZE bytes) is read, the rest
+ *        stays in receive buffer until fetch() or next packetReceive().
  * @param [in] packet - pointer where packet data should be stored
  * @param [in] maxLen  - maximum acceptable length of a retrieved packet
  * @retval packet length in bytes if a packet was retrieved, zero otherwise
  */
 size_t Enc28j60::packetReceive(uint8_t* packet, size_t maxLen)
 {
-    // check if a packet has been received and buffered
-    //if( !(enc28j60Read(EIR) & EIR_PKTIF) ){
-    // The above does not work. See Rev. B4 Silicon Errata point 6.
-    if(readReg(EPKTCNT) == 0) {
-        return 0;
+    while(true) {
+        // the previous packet is skipped, if it was not fetched
+        if(_isPacketHeld) {
+            releasePacket();
+        }
+
+        // check if a packet has been received and buffered
+        //if( !(enc28j60Read(EIR) & EIR_PKTIF) ){
+        // The above does not work. See Rev. B4 Silicon Errata point 6.
+        // The counter is read once per batch, the whole batch is drained
+        // before the next read.
+        if(0 == _pendingPackets) {
+            _pendingPackets = readReg(EPKTCNT);
+            if(0 == _pendingPackets) {
+                return 0;
+            }
+            updateTelemetry();
+        }
+
+        const size_t len = readPacket(packet, maxLen);
+        if(len != 0) {
+            return len;
+        }
     }
+}
 
+/**
+ * @brief Read next packet of batch: header and head of data
+ *        by one RBM operation
+ * @param [in] packet - pointer where packet data should be stored
+ * @param [in] maxLen  - maximum acceptable length of a retrieved packet
+ * @retval packet length in bytes, zero if packet is invalid
+ */
+size_t Enc28j60::readPacket(uint8_t* packet, size_t maxLen)
+{
     // Set the read pointer to the start of the received packet
     writeReg(ERDPTL, _nextPacketPtr);
     writeReg(ERDPTH, _nextPacketPtr >> 8);
+    _rxDataPtr = rxWrap(_nextPacketPtr + RX_HEADER_SIZE);
+    _isPacketHeld = true;
 
-    // read the next packet pointer
-    _nextPacketPtr = readOp(ENC28J60_READ_BUF_MEM, 0);
-    _nextPacketPtr |= readOp(ENC28J60_READ_BUF_MEM, 0) << 8;
+    _profiler.spiTransaction();
+    _interface.setSelect(true);
+    _interface.sendByte(ENC28J60_READ_BUF_MEM);
 
-    // read the packet length (see datasheet page 43)
-    size_t len = readOp(ENC28J60_READ_BUF_MEM, 0);
-    len |= readOp(ENC28J60_READ_BUF_MEM, 0) << 8;
-    len -= 4;    //remove the CRC count
+    // read the next packet pointer, the packet length and the receive status
+    // (see datasheet page 43)
+    uint8_t header[RX_HEADER_SIZE];
+    for(size_t i = 0; i < RX_HEADER_SIZE; ++i) {
+        header[i] = _interface.getByte();
+    }
+    _nextPacketPtr = header[0] | (header[1] << 8);
+    size_t len = header[2] | (header[3] << 8);
+    const uint16_t rxstat = header[4] | (header[5] << 8);
 
-    // read the receive status (see datasheet page 43)
-    uint16_t rxstat = readOp(ENC28J60_READ_BUF_MEM, 0);
-    rxstat |= readOp(ENC28J60_READ_BUF_MEM, 0) << 8;
+    // the header is out of ring: the ring is corrupted (overflow on burst)
+    const size_t rxSize = _rxStop - RXSTART_INIT + 1;
+    if((_nextPacketPtr > _rxStop) || (len < 4) || (len > rxSize)) {
+        _interface.setSelect(false);
+        resetReceive();
+        return 0;
+    }
+    len -= 4;    //remove the CRC count
 
     // limit retrieve length
     const size_t limit = maxLen - 1;
@@ -279,74 +646,719 @@ size_t Enc28j60::packetReceive(uint8_t* packet, size_t maxLen)
     if((rxstat & 0x80) == 0) {
         // invalid
         len = 0;
+        ++_statistics.rxErrors;
+        _interface.setSelect(false);
     }
     else {
-        // copy the packet from the receive buffer
-        readBuffer(packet, len);
+        // copy the head of packet from the receive buffer
+        _rxFetched = (len < Ethernet::HEAD_SIZE) ?
+            len :
+            static_cast<size_t>(Ethernet::HEAD_SIZE);
+        receiveBurst(packet, _rxFetched);
     }
 
-    // Move the RX read pointer to the start of the next received packet
-    // This frees the memory we just read out
-    writeReg(ERXRDPTL, _nextPacketPtr);
-    writeReg(ERXRDPTH, _nextPacketPtr >> 8);
+    _rxLen = len;
+    return len;
+}
+
+/**
+ * @brief Read the rest of received packet after its head
+ *        (random access by ERDPT)
+ * @param [in] packet - pointer on packet, the head is already there
+ */
+void Enc28j60::fetch(uint8_t* packet)
+{
+    if(!_isPacketHeld || (_rxFetched >= _rxLen)) {
+        return;
+    }
+
+    const size_t ptr = rxWrap(_rxDataPtr + _rxFetched);
+    writeReg(ERDPTL, ptr);
+    writeReg(ERDPTH, ptr >> 8);
+    // the read pointer wraps from ERXND to ERXST by itself
+    readBuffer(packet + _rxFetched, _rxLen - _rxFetched);
+    _rxFetched = _rxLen;
+}
+
+/**
+ * @brief Done with current packet, the memory is freed with the last packet
+ *        of batch
+ */
+void Enc28j60::releasePacket()
+{
+    _isPacketHeld = false;
 
     // decrement the packet counter indicate we are done with this packet
-    writeOp(ENC28J60_BIT_FIELD_SET, ECON2, ECON2_PKTDEC);
-    return len;
+    setBits(ECON2, ECON2_PKTDEC);
+
+    if(0 == --_pendingPackets) {
+        freeReceived();
+    }
 }
 
-void Enc28j60::packetSend(const uint8_t* packet, size_t len)
+/**
+ * @brief Wrap address of receive buffer
+ * @param [in] ptr - address, may be beyond end of receive buffer
+ * @retval address inside receive buffer
+ */
+size_t Enc28j60::rxWrap(size_t ptr) const
 {
-    // Set the write pointer to start of transmit buffer area
-    writeReg(EWRPTL, TXSTART_INIT & 0xFF);
-    writeReg(EWRPTH, TXSTART_INIT >> 8);
-    // Set the TXND pointer to correspond to the packet size given
-    writeReg(ETXNDL, (TXSTART_INIT + len) & 0xFF);
-    writeReg(ETXNDH, (TXSTART_INIT + len) >> 8);
+    if(ptr > _rxStop) {
+        ptr -= (_rxStop - RXSTART_INIT + 1);
+    }
+    return ptr;
+}
+
+/**
+ * @brief Split SRAM into RX ring (from address 0) and TX slots (at end)
+ * @param [in] txSlots - number of TX slots
+ * @param [in] txSlotSize - size of TX slot
+ * @retval false if partition is wrong, it is not applied
+ */
+bool Enc28j60::initPartition(uint8_t txSlots, size_t txSlotSize)
+{
+    if(!isValidPartition(txSlots, txSlotSize)) {
+        return false;
+    }
+
+    const size_t txSize = txSlots * txSlotSize;
+    _txStart = BUFFER_SIZE - txSize;
+    _rxStop = _txStart - 1;
+    _txSlots = txSlots;
+    _txSlotSize = txSlotSize;
+    return true;
+}
+
+/**
+ * @brief Update occupancy of RX ring on start of batch
+ */
+void Enc28j60::updateTelemetry()
+{
+    if(_pendingPackets > _telemetry.maxPacketCount) {
+        _telemetry.maxPacketCount = _pendingPackets;
+    }
+    // the counter stops at 255, further packets are dropped by ENC28J60
+    if(0xFF == _pendingPackets) {
+        ++_telemetry.packetCountSaturations;
+    }
+
+    const size_t rxWritePtr = readReg(ERXWRPTL) | (readReg(ERXWRPTH) << 8);
+    const size_t rxSize = _rxStop - RXSTART_INIT + 1;
+    const size_t used = (rxWritePtr + rxSize - _nextPacketPtr) % rxSize;
+    if(used > _telemetry.rxHighWater) {
+        _telemetry.rxHighWater = used;
+    }
+}
+
+const Enc28j60::Telemetry& Enc28j60::getTelemetry() const
+{
+    return _telemetry;
+}
+
+void Enc28j60::resetTelemetry()
+{
+    _telemetry.rxSize = _rxStop - RXSTART_INIT + 1;
+    _telemetry.txSlots = _txSlots;
+    _telemetry.txSlotSize = _txSlotSize;
+    _telemetry.rxHighWater = 0;
+    _telemetry.maxPacketCount = 0;
+    _telemetry.packetCountSaturations = 0;
+}
+
+/**
+ * @brief Move the RX read pointer to the start of the next received packet.
+ *        This frees the memory of all packets read out in the batch.
+ */
+void Enc28j60::freeReceived()
+{
+    // ERXRDPT must be odd. See Rev. B7 Silicon Errata point 14.
+    const size_t rxReadPtr =
+        (_nextPacketPtr == RXSTART_INIT) ? _rxStop : _nextPacketPtr - 1;
+    writeReg(ERXRDPTL, rxReadPtr);
+    writeReg(ERXRDPTH, rxReadPtr >> 8);
+}
+
+/**
+ * @brief Load packet into free TX slot and queue it for transmit.
+ *        Loading runs while the MAC transmits the previous slot.
+ * @param [in] packet - pointer on packet data
+ * @param [in] len - length of packet
+ */
+void Enc28j60::send(const uint8_t* packet, size_t len)
+{
+    if((len + TX_SLOT_OVERHEAD) > _txSlotSize) {
+        return;
+    }
+
+    const uint8_t slot = allocateTxSlot();
+    writeTxSlot(slot, packet, len);
+    queueTxSlot(slot, len);
+}
+
+/**
+ * @brief Send reply to current received packet. The head of reply is
+ *        written over SPI, the rest is copied by DMA of ENC28J60 from
+ *        the received packet (at the same offset), it does not cross SPI.
+ * @param [in] head - pointer on head of reply
+ * @param [in] headLen - length of head
+ * @param [in] len - length of reply
+ * @param [in] checksumStart - start of checksummed part of reply,
+ *             zero - the checksum in head is used as is
+ * @param [in] checksumPos - position of checksum (inside head)
+ */
+void Enc28j60::sendReply(uint8_t* head,
+    size_t headLen,
+    size_t len,
+    size_t checksumStart,
+    size_t checksumPos)
+{
+    if((len + TX_SLOT_OVERHEAD) > _txSlotSize) {
+        return;
+    }
+    if(headLen > len) {
+        headLen = len;
+    }
+
+    const bool isOffload = _isChecksumOffload && (checksumStart != 0);
+    if(isOffload) {
+        head[checksumPos] = 0;
+        head[checksumPos + 1] = 0;
+    }
+
+    const uint8_t slot = allocateTxSlot();
+    writeTxSlot(slot, head, headLen);
+
+    // skip the control byte of slot
+    const size_t start = txSlotStart(slot) + 1;
+    if(len > headLen) {
+        dmaCopy(rxWrap(_rxDataPtr + headLen),
+            rxWrap(_rxDataPtr + len - 1),
+            start + headLen);
+    }
+
+    if(isOffload) {
+        const uint16_t crc =
+            dmaChecksum(start + checksumStart, start + len - 1);
+        const uint8_t checksum[] = { static_cast<uint8_t>(crc >> 8),
+            static_cast<uint8_t>(crc & 0xFF) };
+        writeReg(EWRPTL, (start + checksumPos) & 0xFF);
+        writeReg(EWRPTH, (start + checksumPos) >> 8);
+        writeBuffer(checksum, sizeof(checksum));
+    }
+
+    queueTxSlot(slot, len);
+}
+
+/**
+ * @brief Wait for free TX slot
+ * @retval number of free TX slot
+ */
+uint8_t Enc28j60::allocateTxSlot()
+{
+    serviceTransmit();
+    while(_txSlots == _txCount) {
+        serviceTransmit();
+    }
+    return (_txHead + _txCount) % _txSlots;
+}
+
+/**
+ * @brief Write control byte and packet into TX slot
+ * @param [in] slot - number of TX slot
+ * @param [in] packet - pointer on packet data
+ * @param [in] len - length of packet
+ */
+void Enc28j60::writeTxSlot(uint8_t slot, const uint8_t* packet, size_t len)
+{
+    const size_t start = txSlotStart(slot);
+
+    // Set the write pointer to start of transmit slot
+    writeReg(EWRPTL, start & 0xFF);
+    writeReg(EWRPTH, start >> 8);
+
+    _profiler.spiTransaction();
+    _interface.setSelect(true);
+    _interface.sendByte(ENC28J60_WRITE_BUF_MEM);
     // write per-packet control byte (0x00 means use macon3 settings)
-    writeOp(ENC28J60_WRITE_BUF_MEM, 0, 0x00);
+    _interface.sendByte(0x00);
     // copy the packet into the transmit buffer
-    writeBuffer(packet, len);
-    // send the contents of the transmit buffer onto the network
-    writeOp(ENC28J60_BIT_FIELD_SET, ECON1, ECON1_TXRTS);
+    transmitBurst(packet, len);
+}
+
+/**
+ * @brief Queue loaded TX slot for transmit
+ * @param [in] slot - number of TX slot
+ * @param [in] len - length of packet
+ */
+void Enc28j60::queueTxSlot(uint8_t slot, size_t len)
+{
+    _txLen[slot] = len;
+    ++_txCount;
+
+    serviceTransmit();
+}
+
+size_t Enc28j60::txSlotStart(uint8_t slot) const
+{
+    return _txStart + slot * _txSlotSize;
+}
+
+/**
+ * @brief Copy memory of ENC28J60 by its DMA, the source wraps
+ *        inside receive buffer
+ * @param [in] start - address of first byte of source
+ * @param [in] end - address of last byte of source
+ * @param [in] dest - address of destination
+ */
+void Enc28j60::dmaCopy(size_t start, size_t end, size_t dest)
+{
+    const RegValue dmaScript[] = { { EDMASTL, static_cast<uint8_t>(start) },
+        { EDMASTH, static_cast<uint8_t>(start >> 8) },
+        { EDMANDL, static_cast<uint8_t>(end) },
+        { EDMANDH, static_cast<uint8_t>(end >> 8) },
+        { EDMADSTL, static_cast<uint8_t>(dest) },
+        { EDMADSTH, static_cast<uint8_t>(dest >> 8) } };
+    writeRegs(dmaScript, sizeof(dmaScript) / sizeof(dmaScript[0]));
+
+    clearBits(ECON1, ECON1_CSUMEN);
+    setBits(ECON1, ECON1_DMAST);
+    while(readReg(ECON1) & ECON1_DMAST) {
+    }
+}
+
+/**
+ * @brief Checksum of memory of ENC28J60 by its DMA, the range wraps
+ *        inside receive buffer
+ * @param [in] start - address of first byte
+ * @param [in] end - address of last byte
+ * @retval checksum (big-endian value, as CalcCrc)
+ */
+uint16_t Enc28j60::dmaChecksum(size_t start, size_t end)
+{
+    const RegValue dmaScript[] = { { EDMASTL, static_cast<uint8_t>(start) },
+        { EDMASTH, static_cast<uint8_t>(start >> 8) },
+        { EDMANDL, static_cast<uint8_t>(end) },
+        { EDMANDH, static_cast<uint8_t>(end >> 8) } };
+    writeRegs(dmaScript, sizeof(dmaScript) / sizeof(dmaScript[0]));
+
+    setBits(ECON1, ECON1_CSUMEN);
+    setBits(ECON1, ECON1_DMAST);
+    while(readReg(ECON1) & ECON1_DMAST) {
+    }
+
+    return (readReg(EDMACSH) << 8) | readReg(EDMACSL);
+}
+
+/**
+ * @brief Compare checksum of DMA with software checksum on test pattern
+ *        (written into first TX slot)
+ * @retval true - offload gives the same result
+ */
+bool Enc28j60::testChecksumOffload()
+{
+    uint8_t pattern[CHECKSUM_TEST_SIZE];
+    for(size_t i = 0; i < CHECKSUM_TEST_SIZE; ++i) {
+        pattern[i] = 0xA5 ^ (i * 37);
+    }
+
+    const size_t start = txSlotStart(0);
+    writeReg(EWRPTL, start & 0xFF);
+    writeReg(EWRPTH, start >> 8);
+    writeBuffer(pattern, CHECKSUM_TEST_SIZE);
+
+    const uint16_t hardware =
+        dmaChecksum(start, start + CHECKSUM_TEST_SIZE - 1);
+    const uint16_t software = Ethernet::CalcCrc(
+        pattern, CHECKSUM_TEST_SIZE, Ethernet::PacketType_t::IP);
+    return (hardware == software);
+}
+
+/**
+ * @brief Check checksum of part of current received packet, the checksum
+ *        field is inside the part. The offload checks it in receive buffer,
+ *        software fetches the rest of packet and checks it in the buffer.
+ * @param [in,out] frame - buffer of packet, the head is already there
+ * @param [in] offset - offset of part in packet
+ * @param [in] len - length of part
+ * @retval true - checksum is valid
+ */
+bool Enc28j60::isValidChecksum(uint8_t* frame,
+    size_t offset,
+    size_t len)
+{
+    if((0 == len) || (len > _rxLen) || (offset > (_rxLen - len))) {
+        return false;
+    }
+
+    if(_isChecksumOffload) {
+        return 0 ==
+               dmaChecksum(rxWrap(_rxDataPtr + offset),
+                   rxWrap(_rxDataPtr + offset + len - 1));
+    }
+
+    // the part is not in buffer yet, it is read out for software check
+    if((offset + len) > _rxFetched) {
+        fetch(frame);
+        if((offset + len) > _rxFetched) {
+            return false;
+        }
+    }
+    return NetDevice::isValidChecksum(frame, offset, len);
+}
+
+/**
+ * @brief Free the slot of complete transmission and start the next slot
+ */
+void Enc28j60::serviceTransmit()
+{
+    if(_isTransmit) {
+        const bool isRunning = (readReg(ECON1) & ECON1_TXRTS) != 0;
+        const bool isError = (readReg(EIR) & EIR_TXERIF) != 0;
+        if(isRunning) {
+            // the MAC is still transmitting
+            if(!isError) {
+                return;
+            }
+            // stalled transmit logic, the frame is aborted.
+            // See Rev. B4 Silicon Errata point 12.
+            clearBits(ECON1, ECON1_TXRTS);
+        }
+        if(isError) {
+            // the frame is aborted (e.g. late collision or giant frame):
+            // TXERIF keeps INT asserted, so it is cleared with the slot
+            resetTransmit();
+        }
+        _isTransmit = false;
+        _txHead = (_txHead + 1) % _txSlots;
+        --_txCount;
+    }
+
+    if(_txCount != 0) {
+        startTransmit(_txHead);
+    }
+}
+
+/**
+ * @brief Send the contents of the transmit slot onto the network
+ * @param [in] slot - number of TX slot
+ */
+void Enc28j60::startTransmit(uint8_t slot)
+{
+    const size_t start = txSlotStart(slot);
+    const size_t end = start + _txLen[slot];
+
     // Reset the transmit logic problem. See Rev. B4 Silicon Errata point 12.
     if((readReg(EIR) & EIR_TXERIF)) {
-        writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, ECON1_TXRTS);
+        resetTransmit();
     }
+
+    writeReg(ETXSTL, start & 0xFF);
+    writeReg(ETXSTH, start >> 8);
+    // Set the TXND pointer to correspond to the packet size given
+    writeReg(ETXNDL, end & 0xFF);
+    writeReg(ETXNDH, end >> 8);
+
+    clearBits(EIR, EIR_TXIF);
+    setBits(ECON1, ECON1_TXRTS);
+    _isTransmit = true;
 }
 
-bool Enc28j60::isError() const
+/**
+ * @brief Set receive filters
+ * @param [in] filters - combination of Filter
+ */
+void Enc28j60::setReceiveFilter(uint8_t filters)
 {
-    return _isError;
+    disableReceive();
+    writeReg(ERXFCON, filters);
+    enableReceive();
 }
 
-void Enc28j60::update()
+/**
+ * @brief Set pattern match filter, the checksum of pattern is calculated
+ * @param [in] offset - offset of pattern window in packet
+ * @param [in] pattern - bytes of pattern window
+ * @param [in] len - length of pattern window (not more than 64 bytes)
+ * @param [in] mask - bytes of window for match (bit 0 - first byte)
+ */
+void Enc28j60::setPatternMatch(size_t offset,
+    const uint8_t* pattern,
+    size_t len,
+    uint64_t mask)
 {
-    while(true) {
-        const size_t pacLen = packetReceive(_buffer, _bufSize);
-        if(0 == pacLen) {
-            return;
+    if(len > PATTERN_WINDOW_SIZE) {
+        len = PATTERN_WINDOW_SIZE;
+    }
+
+    // the checksum is calculated over the masked bytes only
+    uint8_t masked[PATTERN_WINDOW_SIZE];
+    size_t size = 0;
+    for(size_t i = 0; i < len; ++i) {
+        if(mask & (static_cast<uint64_t>(1) << i)) {
+            masked[size++] = pattern[i];
+        }
+    }
+    const uint16_t checksum =
+        Ethernet::CalcCrc(masked, size, Ethernet::PacketType_t::IP);
+
+    const RegValue patternScript[] = {
+        { EPMM0, static_cast<uint8_t>(mask) },
+        { EPMM1, static_cast<uint8_t>(mask >> 8) },
+        { EPMM2, static_cast<uint8_t>(mask >> 16) },
+        { EPMM3, static_cast<uint8_t>(mask >> 24) },
+        { EPMM4, static_cast<uint8_t>(mask >> 32) },
+        { EPMM5, static_cast<uint8_t>(mask >> 40) },
+        { EPMM6, static_cast<uint8_t>(mask >> 48) },
+        { EPMM7, static_cast<uint8_t>(mask >> 56) },
+        { EPMCSL, static_cast<uint8_t>(checksum & 0xFF) },
+        { EPMCSH, static_cast<uint8_t>(checksum >> 8) },
+        { EPMOL, static_cast<uint8_t>(offset & 0xFF) },
+        { EPMOH, static_cast<uint8_t>(offset >> 8) }
+    };
+
+    disableReceive();
+    writeRegs(
+        patternScript, sizeof(patternScript) / sizeof(patternScript[0]));
+    enableReceive();
+}
+
+/**
+ * @brief Set hash table filter
+ * @param [in] table - 64 bits of hash table (EHT0-EHT7)
+ */
+void Enc28j60::setHashTable(const uint8_t* table)
+{
+    memcpy(_hashTable, table, HASH_TABLE_SIZE);
+
+    disableReceive();
+    for(size_t i = 0; i < HASH_TABLE_SIZE; ++i) {
+        writeReg(EHT0 + i, _hashTable[i]);
+    }
+    writeReg(ERXFCON, readReg(ERXFCON) | ERXFCON_HTEN);
+    enableReceive();
+}
+
+/**
+ * @brief Accept packets of multicast address by hash table filter
+ * @param [in] macAddr - destination multicast address
+ */
+void Enc28j60::addMulticast(const uint8_t* macAddr)
+{
+    // the pointer is the bits 28:23 of CRC of destination address
+    const uint8_t pointer =
+        (crcEthernet(macAddr, MAC_ADDR_SIZE) >> 23) & 0x3F;
+    const uint8_t index = pointer >> 3;
+    _hashTable[index] |= (1 << (pointer & 0x07));
+
+    disableReceive();
+    writeReg(EHT0 + index, _hashTable[index]);
+    writeReg(ERXFCON, readReg(ERXFCON) | ERXFCON_HTEN);
+    enableReceive();
+}
+
+/**
+ * @brief Remove all multicast addresses from hash table filter
+ */
+void Enc28j60::clearMulticast()
+{
+    memset(_hashTable, 0, HASH_TABLE_SIZE);
+
+    disableReceive();
+    writeReg(ERXFCON, readReg(ERXFCON) & ~ERXFCON_HTEN);
+    for(size_t i = 0; i < HASH_TABLE_SIZE; ++i) {
+        writeReg(EHT0 + i, 0);
+    }
+    enableReceive();
+}
+
+/**
+ * @brief Set boundaries of RX ring, the ring is empty
+ */
+void Enc28j60::initRing()
+{
+    const RegValue ringScript[] = {
+        // Rx start (the write pointer is set to it too)
+        { ERXSTL, RXSTART_INIT & 0xFF },
+        { ERXSTH, RXSTART_INIT >> 8 },
+        // set receive pointer address
+        { ERXRDPTL, static_cast<uint8_t>(_rxStop & 0xFF) },
+        { ERXRDPTH, static_cast<uint8_t>(_rxStop >> 8) },
+        // RX end
+        { ERXNDL, static_cast<uint8_t>(_rxStop & 0xFF) },
+        { ERXNDH, static_cast<uint8_t>(_rxStop >> 8) }
+    };
+    writeRegs(ringScript, sizeof(ringScript) / sizeof(ringScript[0]));
+}
+
+/**
+ * @brief Reset RX logic without full initialization: the ring is emptied
+ *        and the next packet pointer is synchronized with it
+ */
+void Enc28j60::resetReceive()
+{
+    ++_statistics.rxResets;
+
+    disableReceive();
+    setBits(ECON1, ECON1_RXRST);
+    clearBits(ECON1, ECON1_RXRST);
+    initRing();
+
+    // the counted packets are lost with the ring
+    for(size_t i = 0; (i < 0xFF) && (readReg(EPKTCNT) != 0); ++i) {
+        setBits(ECON2, ECON2_PKTDEC);
+    }
+    clearBits(EIR, EIR_RXERIF);
+
+    _nextPacketPtr = RXSTART_INIT;
+    _pendingPackets = 0;
+    _isPacketHeld = false;
+    _rxLen = 0;
+    _rxFetched = 0;
+
+    enableReceive();
+}
+
+/**
+ * @brief Reset TX logic after transmit error, the errors are counted
+ */
+void Enc28j60::resetTransmit()
+{
+    ++_statistics.txErrors;
+
+    const uint8_t estat = readReg(ESTAT);
+    if(estat & ESTAT_TXABRT) {
+        ++_statistics.txAborts;
+    }
+    if(estat & ESTAT_LATECOL) {
+        ++_statistics.lateCollisions;
+    }
+
+    setBits(ECON1, ECON1_TXRST);
+    clearBits(ECON1, ECON1_TXRST);
+    clearBits(EIR, EIR_TXERIF);
+    clearBits(ESTAT, ESTAT_TXABRT | ESTAT_LATECOL);
+}
+
+/**
+ * @brief Recover the errors of interrupt flags, the flags are cleared
+ *        (the interrupt pin is released)
+ * @param [in] eir - value of EIR
+ */
+void Enc28j60::recoverErrors(uint8_t eir)
+{
+    if(eir & EIR_RXERIF) {
+        // the packets are dropped by ENC28J60, the ring is still valid
+        ++_statistics.rxOverflows;
+        clearBits(EIR, EIR_RXERIF);
+    }
+
+    // the frame in progress is finished (or aborted) by serviceTransmit
+    if((eir & EIR_TXERIF) && !_isTransmit) {
+        resetTransmit();
+    }
+}
+
+const Enc28j60::Statistics& Enc28j60::getStatistics() const
+{
+    return _statistics;
+}
+
+void Enc28j60::resetStatistics()
+{
+    memset(&_statistics, 0, sizeof(_statistics));
+}
+
+
+/**
+ * @brief Stop receive of new packets before change of filters
+ */
+void Enc28j60::disableReceive()
+{
+    clearBits(ECON1, ECON1_RXEN);
+    while(readReg(ESTAT) & ESTAT_RXBUSY) {
+    }
+}
+
+void Enc28j60::enableReceive()
+{
+    setBits(ECON1, ECON1_RXEN);
+}
+
+/**
+ * @brief CRC-32 of ethernet (as MAC calculates for hash table filter)
+ * @param [in] data - pointer on data
+ * @param [in] len - length of data
+ * @retval CRC
+ */
+uint32_t Enc28j60::crcEthernet(const uint8_t* data, size_t len)
+{
+    constexpr uint32_t POLYNOMIAL = 0x04C11DB7;
+
+    uint32_t crc = 0xFFFFFFFF;
+    for(size_t i = 0; i < len; ++i) {
+        uint8_t octet = data[i];
+        for(size_t bit = 0; bit < 8; ++bit) {
+            const bool isXor = ((crc >> 31) ^ (octet & 0x01)) != 0;
+            crc <<= 1;
+            if(isXor) {
+                crc ^= POLYNOMIAL;
+            }
+            octet >>= 1;
         }
+    }
+    return crc;
+}
 
-        // arp is broadcast if unknown but a host may also verify the mac address by sending it to a unicast address
-        if(Ethernet::ethTypeIsArp(_buffer, pacLen, _ipAddr)) {
-            const size_t ansLel = Ethernet::MakeArpAnswerFromRequest(
-                _buffer, pacLen, _macAddr, _ipAddr);
-            packetSend(_buffer, ansLel);
-            continue;
+/**
+ * @brief Interrupt of ENC28J60. Only the event is recorded,
+ *        the packets are processed by NetStack::poll() from main loop.
+ */
+void Enc28j60::update()
+{
+    // the queue is full only if events are already pending
+    _events.push(EVENT_INTERRUPT);
+}
+
+/**
+ * @brief Process the events of interrupt and get next received packet,
+ *        calling from main loop
+ * @param [in] frame - pointer where head of packet should be stored
+ * @param [in] maxLen - maximum acceptable length of a retrieved packet
+ * @retval packet length in bytes, zero if receive buffer is empty
+ */
+size_t Enc28j60::receive(uint8_t* frame, size_t maxLen)
+{
+    bool isInterrupt = false;
+    Event event;
+    while(_events.pop(event)) {
+        if(EVENT_INTERRUPT == event) {
+            isInterrupt = true;
         }
+    }
 
-        // check if the ip packet is for us
-        if(!(Ethernet::ethTypeIsIp(_buffer, pacLen, _ipAddr))) {
-            continue;
+    if(isInterrupt) {
+        const uint8_t eir = readReg(EIR);
+        if(eir & (EIR_RXERIF | EIR_TXERIF)) {
+            recoverErrors(eir);
         }
+        // EIR.PKTIF is not reliable. See Rev. B4 Silicon Errata point 6.
+        _isRxPending = true;
+    }
 
-        // ICMP Echo (ping)
-        if(Ethernet::ethTypeIsIcmpEcho(_buffer, pacLen)) {
-            const size_t ansLel = Ethernet::MakeIcmpEchoAnswerFromRequest(
-                _buffer, pacLen, _macAddr, _ipAddr);
-            packetSend(_buffer, ansLel);
-            continue;
+    if(_isRxPending) {
+        const size_t len = packetReceive(frame, maxLen);
+        if(len != 0) {
+            return len;
         }
+        // the receive buffer is empty, the next packet raises interrupt
+        _isRxPending = false;
     }
-}
\ No newline at end of file
+
+    serviceTransmit();
+    return 0;
+}
+
+const uint8_t* Enc28j60::getMacAddr() const
+{
+    return _macAddr;
+}
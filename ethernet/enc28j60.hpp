@@ -27,7 +27,10 @@
 #include "utils/non_movable.hpp"
 
 /* Driver interface */
-#include "utils\spi_interface.hpp"
+#include "utils/spi_interface.hpp"
+#include "dma_interface.hpp"
+#include "spsc_queue.hpp"
+#include "net_device.hpp"
 
 /* User lib */
 #include "ethernet.hpp"
@@ -38,28 +41,130 @@
 class Enc28j60 final
     : private NonCopyable<Enc28j60>
     , private NonMovable<Enc28j60>
-    , public SubjectObserver {
+    , public SubjectObserver
+    , public NetDevice {
   public:
-    static constexpr size_t IP_ADDR_SIZE = 4;
-    static constexpr size_t MAC_ADDR_SIZE = 6;
+    static constexpr size_t PATTERN_WINDOW_SIZE = 64;
+    static constexpr size_t HASH_TABLE_SIZE = 8;
+
+    /// Error counters (EIR, ESTAT and receive status)
+    struct Statistics {
+        uint32_t configErrors;    ///< Configuration replaced by default one
+        uint32_t rxOverflows;    ///< EIR.RXERIF: ring full or EPKTCNT is 255
+        uint32_t rxErrors;    ///< Packets with CRC or symbol errors
+        uint32_t rxResets;    ///< RX logic reset on corrupted ring
+        uint32_t txErrors;    ///< EIR.TXERIF, TX logic reset
+        uint32_t txAborts;    ///< ESTAT.TXABRT
+        uint32_t lateCollisions;    ///< ESTAT.LATECOL
+    };
+
+    /// Duplex of PHY and MAC (the link partner must be set the same,
+    /// ENC28J60 has not auto-negotiation)
+    enum class Duplex { HALF, FULL };
+
+    /// Receive filters (bits of ERXFCON)
+    enum Filter : uint8_t {
+        FILTER_UNICAST = 0x80,
+        FILTER_AND = 0x40,    ///< all enabled filters must accept packet
+        FILTER_CRC = 0x20,
+        FILTER_PATTERN = 0x10,
+        FILTER_MAGIC_PACKET = 0x08,
+        FILTER_HASH = 0x04,
+        FILTER_MULTICAST = 0x02,
+        FILTER_BROADCAST = 0x01
+    };
 
     struct Config {
-        uint8_t ipAddr[IP_ADDR_SIZE];
         uint8_t macAddr[MAC_ADDR_SIZE];
-        uint16_t tcpPort;
-        size_t sizeBuf;
+        DmaInterface* dma;    ///< Channel of bursts, nullptr - polled mode
+        bool checksumOffload;    ///< Checksums by DMA of ENC28J60
+        uint8_t txSlots;    ///< TX slots at end of SRAM, the rest is RX ring
+        uint16_t txSlotSize;    ///< Size of TX slot (even)
+        Duplex duplex;    ///< Set by hand to match port of switch
+        /// Called repeatedly while DMA burst runs, e.g. work of main loop
+        /// out of network stack, nullptr - DMA is polled
+        DmaInterface::Callback idle;
+        void* idleContext;    ///< Argument of idle function
+
+        Config() :
+            dma(nullptr),
+            checksumOffload(true),
+            txSlots(TX_SLOTS),
+            txSlotSize(TX_SLOT_SIZE),
+            duplex(Duplex::HALF),
+            idle(nullptr),
+            idleContext(nullptr)
+        {
+        }
+    };
 
-        Config() : sizeBuf(MAX_FRAMELEN) {}
+    /// Occupancy of SRAM of ENC28J60
+    struct Telemetry {
+        size_t rxSize;    ///< Size of RX ring
+        size_t txSlots;    ///< Number of TX slots
+        size_t txSlotSize;    ///< Size of TX slot
+        size_t rxHighWater;    ///< Maximum bytes used in RX ring
+        uint8_t maxPacketCount;    ///< Maximum of EPKTCNT
+        uint32_t packetCountSaturations;    ///< EPKTCNT reached 255
     };
 
     Enc28j60(const SpiInterface::Config*, const Config*);
 
-    ~Enc28j60();
+    void reset();
+
+    /**
+     * @brief Check partition of SRAM: TX slots at end, the RX ring end
+     *        must be odd, as ERXRDPT (Rev. B7 Silicon Errata point 14),
+     *        then TX slots are even
+     * @param [in] txSlots - number of TX slots
+     * @param [in] txSlotSize - size of TX slot
+     * @retval true - partition is accepted by constructor
+     */
+    static constexpr bool isValidPartition(uint8_t txSlots, size_t txSlotSize)
+    {
+        return (txSlots > 0) && (txSlots <= MAX_TX_SLOTS) &&
+               (txSlotSize >= MIN_TX_SLOT_SIZE) && !(txSlotSize & 0x01) &&
+               ((txSlots * txSlotSize) <= (BUFFER_SIZE - MIN_RX_SIZE));
+    }
+
+    const Statistics& getStatistics() const;
 
-    bool isError() const;
+    void resetStatistics();
 
     virtual void update();
 
+    size_t receive(uint8_t*, size_t) override;
+
+    void send(const uint8_t*, size_t) override;
+
+    void fetch(uint8_t*) override;
+
+    bool isValidChecksum(uint8_t*, size_t, size_t) override;
+
+    void sendReply(uint8_t*, size_t, size_t, size_t, size_t) override;
+
+    bool isLinkUp() override;
+
+    const uint8_t* getMacAddr() const override;
+
+    void setReceiveFilter(uint8_t);
+
+    void setPatternMatch(size_t, const uint8_t*, size_t, uint64_t);
+
+    void setHashTable(const uint8_t*);
+
+    void addMulticast(const uint8_t*);
+
+    void clearMulticast();
+
+    const Telemetry& getTelemetry() const;
+
+    Duplex getDuplex();
+
+    bool selfTest();
+
+    void resetTelemetry();
+
   private:
     /// ENC28J60 Control Registers
     enum EncControlRegisters : uint8_t {
@@ -309,6 +414,16 @@ class Enc28j60 final
         PHSTAT1_JBSTAT = 0x0002
     };
 
+    /// ENC28J60 PHY PHSTAT2 Register Bit Definitions
+    enum EncPhyPhstat2RegistersBitDefinitions : uint16_t {
+        PHSTAT2_TXSTAT = 0x2000,
+        PHSTAT2_RXSTAT = 0x1000,
+        PHSTAT2_COLSTAT = 0x0800,
+        PHSTAT2_LSTAT = 0x0400,
+        PHSTAT2_DPXSTAT = 0x0200,
+        PHSTAT2_PLRITY = 0x0020
+    };
+
     /// ENC28J60 PHY PHCON2 Register Bit Definitions
     enum EncPhyPhcon2RegistersBitDefinitions : uint16_t {
         PHCON2_FRCLINK = 0x4000,
@@ -340,33 +455,104 @@ class Enc28j60 final
         // The RXSTART_INIT should be zero. See Rev. B4 Silicon Errata
         // buffer boundaries applied to internal 8K ram
         // the entire available packet buffer space is allocated
+        BUFFER_SIZE = 0x2000,
 
-        // start with recbuf at 0/
+        // start with recbuf at 0/, the RX ring is up to first TX slot
         RXSTART_INIT = 0x00,
-        // receive buffer end
-        RXSTOP_INIT = (0x1FFF - 0x0600 - 1),
-        // start TX buffer at 0x1FFF-0x0600, pace for one full ethernet frame (~1500 bytes)
-        TXSTART_INIT = (0x1FFF - 0x0600),
-        // stp TX buffer at end of mem
-        TXSTOP_INIT = 0x1FFF,
-        // max frame length which the conroller will accept:
-        MAX_FRAMELEN =
-            1500,    ///< (note: maximum ethernet frame length would be 1518)
-
-        INITIAL_TCP_SEQUENCE_NUMBER =
-            0x0A,    ///< my initial tcp sequence number
-
-        IP_IDENTIFIER = 0x01
+        // minimum of RX ring: one full ethernet frame with its header
+        MIN_RX_SIZE = 0x0600,
+        // one TX slot: control byte, full ethernet frame and status vector
+        TX_SLOT_SIZE = 0x0600,
+        // minimum of TX slot: control byte, short frame and status vector
+        MIN_TX_SLOT_SIZE = 0x0044,
+        // per-packet control byte and transmit status vector of TX slot
+        TX_SLOT_OVERHEAD = 1 + 7,
+        // number of TX slots: a frame is loaded while other is transmitted
+        TX_SLOTS = 2,
+        MAX_TX_SLOTS = 4,
+        // max frame length (with CRC) which the conroller will accept:
+        MAX_FRAMELEN = Ethernet::MAX_FRAME_SIZE,
+
+        // next packet pointer, length and status vector before packet data
+        RX_HEADER_SIZE = 6,
+
+        // pattern length of SPI link self test
+        SELF_TEST_SIZE = 64,
+
+        // pattern length of checksum offload test (odd for padding test)
+        CHECKSUM_TEST_SIZE = 33,
+
+        // shorter bursts are faster by polling than by DMA setup
+        DMA_MIN_TRANSFER = 16
+    };
+
+    /// Events recorded by interrupt for receive()
+    enum Event : uint8_t {
+        EVENT_INTERRUPT    ///< EIR has pending flags
     };
 
+    /// Capacity of event queue (power of two)
+    static constexpr size_t EVENT_QUEUE_SIZE = 8;
+
+    /// Write-mostly registers kept in shadow
+    enum ShadowRegisters {
+        SHADOW_EIE,
+        SHADOW_ERXFCON,
+        SHADOW_MACON1,
+        SHADOW_MACON2,
+        SHADOW_MACON3,
+        SHADOW_MACON4,
+        SHADOW_SIZE
+    };
+
+    /// Register and value of batch write
+    struct RegValue {
+        uint8_t address;
+        uint8_t data;
+    };
+
+    static const RegValue INIT_SCRIPT[];
+
+    static const RegValue HALF_DUPLEX_SCRIPT[];
+
+    static const RegValue FULL_DUPLEX_SCRIPT[];
+
+    /**
+     * @brief Check that registers of script are grouped by bank
+     *        in increasing order (registers of all banks are in any place)
+     */
+    static constexpr bool isSortedByBank(const RegValue* script,
+        size_t size,
+        uint8_t bank = 0)
+    {
+        return (0 == size) ||
+               ((((script->address & ADDR_MASK) >= EIE) ||
+                    ((script->address & BANK_MASK) >= bank)) &&
+                   isSortedByBank(script + 1,
+                       size - 1,
+                       ((script->address & ADDR_MASK) >= EIE) ?
+                           bank :
+                           (script->address & BANK_MASK)));
+    }
+
     Enc28j60() = delete;
 
     void writeReg(uint8_t, uint8_t);
 
     uint8_t readReg(uint8_t);
 
+    void writeRegs(const RegValue*, size_t);
+
+    void setBits(uint8_t, uint8_t);
+
+    void clearBits(uint8_t, uint8_t);
+
     void setBank(uint8_t);
 
+    static int shadowIndex(uint8_t);
+
+    void resetShadow();
+
     void writeOp(uint8_t, uint8_t, uint8_t);
 
     uint8_t readOp(uint8_t, uint8_t);
@@ -375,31 +561,121 @@ class Enc28j60 final
 
     void readBuffer(uint8_t*, size_t);
 
+    void transmitBurst(const uint8_t*, size_t);
+
+    void receiveBurst(uint8_t*, size_t);
+
+    void waitBurst();
+
+    static void completeBurst(void*);
+
     void phyWrite(uint8_t, uint16_t);
 
+    uint16_t phyRead(uint8_t);
+
     size_t packetReceive(uint8_t*, size_t);
 
-    void packetSend(const uint8_t*, size_t);
+    size_t readPacket(uint8_t*, size_t);
+
+    void releasePacket();
+
+    size_t rxWrap(size_t) const;
+
+    bool initPartition(uint8_t, size_t);
+
+    void updateTelemetry();
+
+    void disableReceive();
+
+    void initRing();
+
+    void resetReceive();
+
+    void resetTransmit();
+
+    void recoverErrors(uint8_t);
+
+    void enableReceive();
+
+    static uint32_t crcEthernet(const uint8_t*, size_t);
+
+    void freeReceived();
+
+    uint8_t allocateTxSlot();
+
+    void writeTxSlot(uint8_t, const uint8_t*, size_t);
+
+    void queueTxSlot(uint8_t, size_t);
+
+    size_t txSlotStart(uint8_t) const;
+
+    void dmaCopy(size_t, size_t, size_t);
+
+    uint16_t dmaChecksum(size_t, size_t);
+
+    bool testChecksumOffload();
+
+    void serviceTransmit();
+
+    void startTransmit(uint8_t);
 
     void initPhy();
 
     SpiInterface _interface;    ///< Interface
 
-    uint8_t _enc28j60Bank;
+    DmaInterface* const _dma;    ///< Bulk transfer, nullptr - polled mode
+
+    uint8_t _enc28j60Bank;    ///< Shadow of bank bits of ECON1
+
+    uint8_t _shadow[SHADOW_SIZE];    ///< Shadow of write-mostly registers
 
     size_t _nextPacketPtr;
 
-    uint8_t _tcpPort;
+    uint8_t _pendingPackets;    ///< Packets of batch still in receive buffer
+
+    size_t _rxDataPtr;    ///< Address of data of current packet
+
+    size_t _rxLen;    ///< Length of current packet
+
+    size_t _rxFetched;    ///< Bytes of current packet read out
+
+    bool _isPacketHeld;    ///< Current packet is not released
+
+    size_t _rxStop;    ///< Last address of RX ring
+
+    size_t _txStart;    ///< Address of first TX slot
+
+    uint8_t _txSlots;    ///< Number of TX slots
+
+    size_t _txSlotSize;    ///< Size of TX slot
+
+    uint16_t _txLen[MAX_TX_SLOTS];    ///< Length of frames in TX slots
+
+    uint8_t _txHead;    ///< TX slot transmitted or next for transmit
+
+    uint8_t _txCount;    ///< Number of loaded TX slots
+
+    bool _isTransmit;    ///< Transmission of head slot is started
 
     uint8_t _macAddr[MAC_ADDR_SIZE];
 
-    uint8_t _ipAddr[IP_ADDR_SIZE];
+    uint8_t _hashTable[HASH_TABLE_SIZE];    ///< Shadow of EHT0-EHT7
+
+    Statistics _statistics;
+
+    bool _isChecksumOffload;    ///< Checksums by DMA of ENC28J60 are used
+
+    Duplex _duplex;    ///< Configured duplex
+
+    SpscQueue<Event, EVENT_QUEUE_SIZE> _events;    ///< Events of interrupt
+
+    bool _isRxPending;    ///< Packets left in receive buffer after receive()
 
-    uint8_t* _buffer;
+    volatile bool _isBurst;    ///< DMA burst holds chip select
 
-    size_t _bufSize;
+    Telemetry _telemetry;
 
-    bool _isError;
+    const Config _config;    ///< Configuration applied by reset()
 };
 
 #endif
\ No newline at end of file
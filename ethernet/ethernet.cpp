@@ -18,63 +18,309 @@
 
 void Ethernet::MakeEth(uint8_t* buf, const uint8_t* macaddr)
 {
+    EthHeader eth(buf);
     //copy the destination mac from the source and fill my mac into src
-    for(size_t i = 0; i < Enc28j60::MAC_ADDR_SIZE; i++) {
-        buf[ETH_DST_MAC + i] = buf[ETH_SRC_MAC + i];
-        buf[ETH_SRC_MAC + i] = macaddr[i];
-    }
+    memcpy(eth.getDstMac(), eth.getSrcMac(), NetDevice::MAC_ADDR_SIZE);
+    memcpy(eth.getSrcMac(), macaddr, NetDevice::MAC_ADDR_SIZE);
 }
 
-void Ethernet::MakeIp(uint8_t* buf, const uint8_t* ipaddr)
+/**
+ * @brief Make IP header of reply from header of request, the checksum
+ *        of request must be valid, it is updated for changed fields only
+ * @param [in] buf - pointer on frame
+ * @param [in] ipaddr - my IP address, see makeIpAddr
+ */
+void Ethernet::MakeIp(uint8_t* buf, uint32_t ipaddr)
 {
-    for(size_t i = 0; i < Enc28j60::IP_ADDR_SIZE; i++) {
-        buf[IP_DST_P + i] = buf[IP_SRC_P + i];
-        buf[IP_SRC_P + i] = ipaddr[i];
-    }
-    FillIpHdrChecksum(buf);
+    IpHeader ip(&buf[IP_P]);
+    uint8_t* checksum = ip.data() + IpHeader::CHECKSUM;
+
+    // the swap of addresses does not change the sum,
+    // only my address replaces destination of request
+    const uint32_t srcaddr = ip.getSrcIp();
+    RewriteWord32(checksum, ip.data() + IpHeader::DST_IP, ipaddr);
+    ip.setDstIp(srcaddr);
+    ip.setSrcIp(ipaddr);
+
+    RewriteWord16(checksum,
+        ip.data() + IpHeader::FLAGS,
+        IpHeader::FLAGS_DONT_FRAGMENT);
+    // ttl, the protocol is kept
+    RewriteWord16(checksum,
+        ip.data() + IpHeader::TTL,
+        (IpHeader::DEFAULT_TTL << 8) | ip.getProtocol());
 }
 
 void Ethernet::FillIpHdrChecksum(uint8_t* buf)
 {
-    // clear the 2 byte checksum
-    buf[IP_CHECKSUM_P] = 0;
-    buf[IP_CHECKSUM_P + 1] = 0;
-    buf[IP_FLAGS_P] = 0x40;     // don't fragment
-    buf[IP_FLAGS_P + 1] = 0;    // fragement offset
-    buf[IP_TTL_P] = 64;         // ttl
+    IpHeader ip(&buf[IP_P]);
+    ip.setChecksum(0);
+    ip.setFlags(IpHeader::FLAGS_DONT_FRAGMENT);
+    ip.setTtl(IpHeader::DEFAULT_TTL);
 
     // calculate the checksum:
-    uint16_t crc = CalcCrc(&buf[IP_P], IP_HEADER_LEN, PacketType_t::IP);
-    buf[IP_CHECKSUM_P] = crc >> 8;
-    buf[IP_CHECKSUM_P + 1] = crc & 0xff;
+    ip.setChecksum(CalcCrc(ip.data(), IpHeader::SIZE, PacketType_t::IP));
+}
+
+/**
+ * @brief Make ethernet and IP headers of new frame, the IP header has not
+ *        options, its checksum is computed
+ * @param [in] buf - pointer on frame
+ * @param [in] dstMac - MAC address of receiver (or of gateway)
+ * @param [in] srcMac - my MAC address
+ * @param [in] dstIp - IP address of receiver, see makeIpAddr
+ * @param [in] srcIp - my IP address
+ * @param [in] protocol - protocol of IP packet (see IpHeader::Protocol)
+ * @param [in] ipLen - length of IP packet with its header
+ * @param [in] id - identifier of IP packet
+ */
+void Ethernet::MakeIpFrame(uint8_t* buf,
+    const uint8_t* dstMac,
+    const uint8_t* srcMac,
+    uint32_t dstIp,
+    uint32_t srcIp,
+    uint8_t protocol,
+    size_t ipLen,
+    uint16_t id)
+{
+    EthHeader eth(buf);
+    memcpy(eth.getDstMac(), dstMac, NetDevice::MAC_ADDR_SIZE);
+    memcpy(eth.getSrcMac(), srcMac, NetDevice::MAC_ADDR_SIZE);
+    eth.setType(EthHeader::TYPE_IP);
+
+    IpHeader ip(&buf[IP_P]);
+    ip.setVerLen(IpHeader::VER_LEN_V4);
+    ip.data()[IpHeader::TOS] = 0;
+    ip.setTotalLen(ipLen);
+    ip.setId(id);
+    ip.setProtocol(protocol);
+    ip.setSrcIp(srcIp);
+    ip.setDstIp(dstIp);
+    FillIpHdrChecksum(buf);
+}
+
+/**
+ * @brief Checksum of UDP or TCP packet with pseudo header (IP addresses,
+ *        protocol and length), the IP header is in frame
+ * @param [in] buf - pointer on frame
+ * @param [in] len - length of UDP or TCP packet with its header
+ * @param [in] type - UDP or TCP
+ * @retval checksum, zero - checksum in packet is valid
+ */
+uint16_t Ethernet::CalcTransportChecksum(uint8_t* buf,
+    size_t len,
+    PacketType_t type)
+{
+    // the addresses are just before UDP or TCP header
+    return CalcCrc(&buf[IP_P + IpHeader::SRC_IP],
+        len + 2 * NetDevice::IP_ADDR_SIZE,
+        type);
+}
+
+/**
+ * @brief Checksum of UDP or TCP packet whose data sum is known (e.g.
+ *        precomputed for constant data), only the headers are summed
+ * @param [in] buf - pointer on frame
+ * @param [in] headerLen - length of UDP or TCP header, even
+ * @param [in] dataLen - length of data after header
+ * @param [in] dataSum - sum of data (see SumWords)
+ * @param [in] type - UDP or TCP
+ * @retval checksum
+ */
+uint16_t Ethernet::CalcTransportChecksum(uint8_t* buf,
+    size_t headerLen,
+    size_t dataLen,
+    uint16_t dataSum,
+    PacketType_t type)
+{
+    uint32_t sum = (type == PacketType_t::UDP) ? IpHeader::PROTOCOL_UDP :
+                                                 IpHeader::PROTOCOL_TCP;
+    sum += headerLen + dataLen;
+    sum += SumWords(&buf[IP_P + IpHeader::SRC_IP],
+        headerLen + 2 * NetDevice::IP_ADDR_SIZE);
+    sum += dataSum;
+    while(sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+namespace {
+    /// Word of 32 bits in byte order of CPU, the address is aligned
+    inline uint32_t loadWord32(const uint8_t* buf)
+    {
+        uint32_t word;
+        memcpy(&word, buf, sizeof(word));
+        return word;
+    }
+
+    /// Word of 16 bits in byte order of CPU, the address is aligned
+    inline uint16_t loadWord16(const uint8_t* buf)
+    {
+        uint16_t word;
+        memcpy(&word, buf, sizeof(word));
+        return word;
+    }
+
+    /**
+     * @brief Sum of 16-bit words in byte order of CPU (RFC 1071), the sum
+     *        is the same for any order up to swap of its bytes
+     * @param [in] buf - pointer on data, the address is even
+     * @param [in] len - length of data
+     * @retval folded sum, zero only if all data is zero
+     */
+    uint16_t sumAlignedWords(const uint8_t* buf, size_t len)
+    {
+        // carries are accumulated in high word, folded once at end
+        uint64_t sum = 0;
+        if((reinterpret_cast<uintptr_t>(buf) & 0x02) && (len > 1)) {
+            sum += loadWord16(buf);
+            buf += 2;
+            len -= 2;
+        }
+        while(len >= 16) {
+            sum += loadWord32(buf);
+            sum += loadWord32(buf + 4);
+            sum += loadWord32(buf + 8);
+            sum += loadWord32(buf + 12);
+            buf += 16;
+            len -= 16;
+        }
+        while(len >= 4) {
+            sum += loadWord32(buf);
+            buf += 4;
+            len -= 4;
+        }
+        if(len > 1) {
+            sum += loadWord16(buf);
+            buf += 2;
+            len -= 2;
+        }
+        // the byte left is padded with zero
+        if(len > 0) {
+            const uint8_t last[2] = { *buf, 0 };
+            sum += loadWord16(last);
+        }
+
+        while(sum >> 16) {
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        return static_cast<uint16_t>(sum);
+    }
+}
+
+/**
+ * @brief Sum of 16-bit big-endian words in one's complement, not inverted.
+ *        The words are loaded by 32 bits in byte order of CPU, the order
+ *        is restored on folded sum only.
+ * @param [in] buf - pointer on data, any alignment
+ * @param [in] len - length of data, the odd byte is padded with zero
+ * @retval folded sum, zero only if all data is zero
+ */
+uint16_t Ethernet::SumWords(const uint8_t* buf, size_t len)
+{
+    if(0 == len) {
+        return 0;
+    }
+
+    // odd address: the first byte is low byte of big-endian word before
+    // the aligned data, the other words are summed with swapped bytes
+    const bool isOdd = reinterpret_cast<uintptr_t>(buf) & 0x01;
+    uint32_t sum = 0;
+    if(isOdd) {
+        sum = *buf++;
+        --len;
+    }
+
+    sum += swapBytes16(sumAlignedWords(buf, len));
+    sum = (sum & 0xFFFF) + (sum >> 16);
+
+    // the byte swap of the odd case is done on any CPU
+    return isOdd ? static_cast<uint16_t>((sum << 8) | (sum >> 8)) : sum;
+}
+
+/**
+ * @brief Update checksum on change of 16-bit word (RFC 1624, eqn. 3):
+ *        HC' = ~(~HC + ~m + m')
+ * @param [in] checksum - checksum before change
+ * @param [in] oldWord - word before change
+ * @param [in] newWord - word after change
+ * @retval checksum after change
+ */
+uint16_t Ethernet::UpdateChecksum16(uint16_t checksum,
+    uint16_t oldWord,
+    uint16_t newWord)
+{
+    uint32_t sum = static_cast<uint16_t>(~checksum) +
+                   static_cast<uint16_t>(~oldWord) + newWord;
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<uint16_t>(~sum);
+}
+
+/**
+ * @brief Update checksum on change of 32-bit word (two 16-bit words)
+ * @param [in] checksum - checksum before change
+ * @param [in] oldWord - word before change
+ * @param [in] newWord - word after change
+ * @retval checksum after change
+ */
+uint16_t Ethernet::UpdateChecksum32(uint16_t checksum,
+    uint32_t oldWord,
+    uint32_t newWord)
+{
+    uint32_t sum = static_cast<uint16_t>(~checksum) +
+                   static_cast<uint16_t>(~oldWord >> 16) +
+                   static_cast<uint16_t>(~oldWord) + (newWord >> 16) +
+                   (newWord & 0xFFFF);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<uint16_t>(~sum);
+}
+
+/**
+ * @brief Write 16-bit field of packet and update its checksum
+ * @param [in] checksum - pointer on checksum
+ * @param [in] field - pointer on field, even from start of checksummed part
+ * @param [in] value - new value of field
+ */
+void Ethernet::RewriteWord16(uint8_t* checksum, uint8_t* field, uint16_t value)
+{
+    putWord16(checksum,
+        UpdateChecksum16(getWord16(checksum), getWord16(field), value));
+    putWord16(field, value);
+}
+
+/**
+ * @brief Write 32-bit field of packet and update its checksum
+ * @param [in] checksum - pointer on checksum
+ * @param [in] field - pointer on field, even from start of checksummed part
+ * @param [in] value - new value of field
+ */
+void Ethernet::RewriteWord32(uint8_t* checksum, uint8_t* field, uint32_t value)
+{
+    putWord16(checksum,
+        UpdateChecksum32(getWord16(checksum), getWord32(field), value));
+    putWord32(field, value);
 }
 
 uint16_t Ethernet::CalcCrc(uint8_t* buf, size_t len, PacketType_t type)
 {
     uint32_t sum = 0;
     if(type == PacketType_t::UDP) {
-        sum += IP_PROTO_UDP_V;    // protocol udp
+        sum += IpHeader::PROTOCOL_UDP;    // protocol udp
         // the length here is the length of udp (data+header len)
         // =length given to this function - (IP.scr+IP.dst length)
         sum += (len - 8);    // = real tcp len
     }
     else if(type == PacketType_t::TCP) {
-        sum += IP_PROTO_TCP_V;
+        sum += IpHeader::PROTOCOL_TCP;
         // the length here is the length of tcp (data+header len)
         // =length given to this function - (IP.scr+IP.dst length)
         sum += (len - 8);    // = real tcp len
     }
 
-    // build the sum of 16bit words
-    while(len > 1) {
-        sum += 0xFFFF & ((*buf << 8) | *(buf + 1));
-        buf += 2;
-        len -= 2;
-    }
-    // if there is a byte left then add it (padded with zero)
-    if(len > 0) {
-        sum += ((0xFF & *buf) << 8);
-    }
+    sum += SumWords(buf, len);
     // now calculate the sum over the bytes in the sum
     // until the result is only 16bit long
     while(sum >> 16) {
@@ -84,97 +330,132 @@ uint16_t Ethernet::CalcCrc(uint8_t* buf, size_t len, PacketType_t type)
     return ((uint16_t)sum ^ 0xFFFF);
 }
 
-bool Ethernet::ethTypeIsIcmpEcho(uint8_t* buf, size_t len)
+/**
+ * @brief Classify received frame in one pass over its headers:
+ *        EtherType, then IP protocol, then ICMP type or port
+ * @param [in] buf - pointer on frame, at least its head (HEAD_SIZE)
+ * @param [in] len - length of frame
+ * @param [in] ipaddr - my IP address, see makeIpAddr
+ * @param [out] info - protocol and key of frame
+ * @retval true - ARP or IP frame for me or UDP datagram of multicast group
+ *         (the IP checksum is not checked)
+ */
+bool Ethernet::ClassifyFrame(uint8_t* buf,
+    size_t len,
+    uint32_t ipaddr,
+    FrameInfo* info)
 {
-    if(0 == len) {
+    info->protocol = Protocol::OTHER;
+    info->key = 0;
+    info->len = len;
+    if(len < EthHeader::SIZE) {
         return false;
     }
 
-    return ((buf[IP_PROTO_P] == IP_PROTO_ICMP_V) &&
-            (buf[ICMP_TYPE_P] == ICMP_TYPE_ECHOREQUEST_V));
-}
+    switch(EthHeader(buf).getType()) {
+        case EthHeader::TYPE_ARP:
+            // arp is broadcast if unknown but a host may also verify
+            // the mac address by sending it to a unicast address
+            if((len < ARP_FRAME_SIZE) ||
+                (ArpHeader(&buf[EthHeader::SIZE]).getDstIp() != ipaddr)) {
+                return false;
+            }
+            info->protocol = Protocol::ARP;
+            return true;
 
-bool Ethernet::ethTypeIsIp(uint8_t* buf, size_t len, const uint8_t* ipaddr)
-{
-    //eth+ip+udp header is 42
-    if(len < ETH_HEADER_SIZE) {
-        return false;
+        case EthHeader::TYPE_IP:
+            break;
+
+        default:
+            return false;
     }
 
-    if((buf[ETH_TYPE_H_P] != ETHTYPE_IP_H_V) ||
-        (buf[ETH_TYPE_L_P] != ETHTYPE_IP_L_V)) {
+    const IpHeader ip(&buf[IP_P]);
+    // must be IP V4 and 20 byte header
+    if((len < TRANSPORT_P) || (ip.getVerLen() != IpHeader::VER_LEN_V4)) {
         return false;
     }
-
-    if(buf[IP_HEADER_LEN_VER_P] != 0x45) {
-        // must be IP V4 and 20 byte header
+    // for me, or UDP of multicast group: the group is selected by hash
+    // filter of device (see Enc28j60::addMulticast), then by bound port
+    if((ip.getDstIp() != ipaddr) &&
+        (!isMulticastIp(ip.getDstIp()) ||
+            (ip.getProtocol() != IpHeader::PROTOCOL_UDP))) {
         return false;
     }
-
-    // I?iaa?yai iao IP aa?an
-    if(memcmp(&buf[IP_DST_P], ipaddr, Enc28j60::IP_ADDR_SIZE) == 0) {
-        return true;
+    // without padding of short ethernet frame
+    if((IP_P + ip.getTotalLen()) < len) {
+        info->len = IP_P + ip.getTotalLen();
     }
-    return false;
-}
 
-bool Ethernet::ethTypeIsArp(uint8_t* buf, size_t len, const uint8_t* ipaddr)
-{
-    if(len < (ETH_HEADER_SIZE - 1)) {
-        return false;
-    }
+    switch(ip.getProtocol()) {
+        case IpHeader::PROTOCOL_ICMP:
+            if(info->len >= (TRANSPORT_P + IcmpHeader::SIZE)) {
+                info->protocol = Protocol::ICMP;
+                info->key = IcmpHeader(&buf[TRANSPORT_P]).getType();
+            }
+            break;
 
-    if((buf[ETH_TYPE_H_P] != ETHTYPE_ARP_H_V) ||
-        (buf[ETH_TYPE_L_P] != ETHTYPE_ARP_L_V)) {
-        return false;
-    }
+        case IpHeader::PROTOCOL_UDP:
+            if(info->len >= (TRANSPORT_P + UdpHeader::SIZE)) {
+                info->protocol = Protocol::UDP;
+                info->key = UdpHeader(&buf[TRANSPORT_P]).getDstPort();
+            }
+            break;
+
+        case IpHeader::PROTOCOL_TCP:
+            if(info->len >= (TRANSPORT_P + TcpHeader::SIZE)) {
+                info->protocol = Protocol::TCP;
+                info->key = TcpHeader(&buf[TRANSPORT_P]).getDstPort();
+            }
+            break;
 
-    // I?iaa?yai iao IP aa?an
-    if(memcmp(&buf[ETH_ARP_DST_IP_P], ipaddr, Enc28j60::IP_ADDR_SIZE) == 0) {
-        return true;
+        default:
+            break;
     }
-    return false;
+    return true;
 }
 
 size_t Ethernet::MakeArpAnswerFromRequest(uint8_t* buf,
     size_t len,
     const uint8_t* macaddr,
-    const uint8_t* ipaddr)
+    uint32_t ipaddr)
 {
     MakeEth(buf, macaddr);
 
-    buf[ETH_ARP_OPCODE_H_P] = ETH_ARP_OPCODE_REPLY_H_V;
-    buf[ETH_ARP_OPCODE_L_P] = ETH_ARP_OPCODE_REPLY_L_V;
+    ArpHeader arp(&buf[EthHeader::SIZE]);
+    arp.setOpcode(ArpHeader::OPCODE_REPLY);
 
     // fill the mac addresses:
-    for(size_t i = 0; i < Enc28j60::MAC_ADDR_SIZE; i++) {
-        buf[ETH_ARP_DST_MAC_P + i] = buf[ETH_ARP_SRC_MAC_P + i];
-        buf[ETH_ARP_SRC_MAC_P + i] = macaddr[i];
-    }
+    memcpy(arp.getDstMac(), arp.getSrcMac(), NetDevice::MAC_ADDR_SIZE);
+    memcpy(arp.getSrcMac(), macaddr, NetDevice::MAC_ADDR_SIZE);
 
-    for(size_t i = 0; i < Enc28j60::IP_ADDR_SIZE; i++) {
-        buf[ETH_ARP_DST_IP_P + i] = buf[ETH_ARP_SRC_IP_P + i];
-        buf[ETH_ARP_SRC_IP_P + i] = ipaddr[i];
-    }
+    arp.setDstIp(arp.getSrcIp());
+    arp.setSrcIp(ipaddr);
     // eth+arp is 42 bytes:
-    return ETH_HEADER_SIZE;
+    return ARP_FRAME_SIZE;
 }
 
 size_t Ethernet::MakeIcmpEchoAnswerFromRequest(uint8_t* buf,
     size_t len,
     const uint8_t* macaddr,
-    const uint8_t* ipaddr)
+    uint32_t ipaddr)
 {
     MakeEth(buf, macaddr);
     MakeIp(buf, ipaddr);
 
-    buf[ICMP_TYPE_P] = ICMP_TYPE_ECHOREPLY_V;
-    // we changed only the icmp.type field from request(=8) to reply(=0).
-    // we can therefore easily correct the checksum:
-    if(buf[ICMP_CHECKSUM_P] > (0xff - 0x08)) {
-        buf[ICMP_CHECKSUM_P + 1]++;
+    IcmpHeader icmp(&buf[TRANSPORT_P]);
+    uint8_t* checksum = icmp.data() + IcmpHeader::CHECKSUM;
+    // we changed only the icmp.type field from request(=8) to reply(=0),
+    // the code is kept
+    RewriteWord16(checksum,
+        icmp.data() + IcmpHeader::TYPE,
+        (IcmpHeader::TYPE_ECHO_REPLY << 8) | icmp.getCode());
+    // the update gives zero for message of all zeros (zero id, sequence
+    // and data), it is invalid, while 0xFFFF is valid for any message
+    // (RFC 1624, section 3), the data is not read to tell them apart
+    if(0 == icmp.getChecksum()) {
+        icmp.setChecksum(0xFFFF);
     }
-    buf[ICMP_CHECKSUM_P] += 0x08;
 
     return len;
-}
\ No newline at end of file
+}
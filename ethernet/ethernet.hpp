@@ -21,184 +21,107 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "enc28j60.hpp"
+#include "net_device.hpp"
+#include "net_headers.hpp"
 
 namespace Ethernet {
-    // notation: _P = position of a field
-    //           _V = value of a field
-    enum {
-        // ******* ETH *******
-        ETH_HEADER_LEN = 14,
-        // values of certain bytes:
-        ETHTYPE_ARP_H_V = 0x08,
-        ETHTYPE_ARP_L_V = 0x06,
-        ETHTYPE_IP_V = 0x0800,
-        ETHTYPE_IP_H_V = 0x08,
-        ETHTYPE_IP_L_V = 0x00,
-        // byte positions in the ethernet frame:
-        //
-        // Ethernet type field (2bytes):
-        ETH_TYPE_H_P = 12,
-        ETH_TYPE_L_P = 13,
-        //
-        ETH_DST_MAC = 0,
-        ETH_SRC_MAC = 6,
-
-        // ******* ARP *******
-        ETH_ARP_OPCODE_REPLY_H_V = 0x0,
-        ETH_ARP_OPCODE_REPLY_L_V = 0x02,
-
-        // arp.dst.ip
-        ETH_ARP_DST_IP_P = 0x26,
-        // arp.opcode
-        ETH_ARP_OPCODE_H_P = 0x14,
-        ETH_ARP_OPCODE_L_P = 0x15,
-        // arp.src.mac
-        ETH_ARP_SRC_MAC_P = 0x16,
-        ETH_ARP_SRC_IP_P = 0x1c,
-        ETH_ARP_DST_MAC_P = 0x20,
-
-        ARP_OPCODE_REQUEST_H_V = 0x00,
-        ARP_OPCODE_REQUEST_L_V = 0x01,
-        ARP_OPCODE_REPLY_H_V = 0x00,
-        ARP_OPCODE_REPLY_L_V = 0x02,
-
-        ARP_HARDWARE_TYPE_H_V = 0x00,
-        ARP_HARDWARE_TYPE_L_V = 0x01,
-        ARP_PROTOCOL_H_V = 0x08,
-        ARP_PROTOCOL_L_V = 0x00,
-        ARP_HARDWARE_SIZE_V = 0x06,
-        ARP_PROTOCOL_SIZE_V = 0x04,
-
-        ARP_HARDWARE_TYPE_H_P = 0x0E,
-        ARP_HARDWARE_TYPE_L_P = 0x0F,
-        ARP_PROTOCOL_H_P = 0x10,
-        ARP_PROTOCOL_L_P = 0x11,
-        ARP_HARDWARE_SIZE_P = 0x12,
-        ARP_PROTOCOL_SIZE_P = 0x13,
-        ARP_OPCODE_H_P = 0x14,
-        ARP_OPCODE_L_P = 0x15,
-        ARP_SRC_MAC_P = 0x16,
-        ARP_SRC_IP_P = 0x1C,
-        ARP_DST_MAC_P = 0x20,
-        ARP_DST_IP_P = 0x26,
-
-        // ******* IP *******
-        IP_HEADER_LEN = 20,
-
-        IP_PROTO_ICMP_V = 0x01,
-        IP_PROTO_TCP_V = 0x06,
-        IP_PROTO_UDP_V = 0x11,
-        IP_V4_V = 0x40,
-        IP_HEADER_LENGTH_V = 0x05,
-
-        IP_P = 0x0E,
-        IP_HEADER_VER_LEN_P = 0x0E,
-        IP_TOS_P = 0x0F,
-        IP_TOTLEN_H_P = 0x10,
-        IP_TOTLEN_L_P = 0x11,
-        IP_ID_H_P = 0x12,
-        IP_ID_L_P = 0x13,
-        IP_FLAGS_P = 0x14,
-        IP_FLAGS_H_P = 0x14,
-        IP_FLAGS_L_P = 0x15,
-        IP_TTL_P = 0x16,
-        IP_PROTO_P = 0x17,
-        IP_CHECKSUM_P = 0x18,
-        IP_CHECKSUM_H_P = 0x18,
-        IP_CHECKSUM_L_P = 0x19,
-        IP_SRC_IP_P = 0x1A,
-        IP_DST_IP_P = 0x1E,
-
-        IP_SRC_P = 0x1A,
-        IP_DST_P = 0x1E,
-        IP_HEADER_LEN_VER_P = 0x0E,
-        // ******* ICMP *******
-        ICMP_TYPE_ECHOREPLY_V = 0,
-        ICMP_TYPE_ECHOREQUEST_V = 8,
-        //
-        ICMP_TYPE_P = 0x22,
-        ICMP_CHECKSUM_P = 0x24,
-
-        // ******* UDP *******
-        UDP_HEADER_LEN = 8,
-        //
-        UDP_SRC_PORT_H_P = 0x22,
-        UDP_SRC_PORT_L_P = 0x23,
-        UDP_DST_PORT_H_P = 0x24,
-        UDP_DST_PORT_L_P = 0x25,
-        //
-        UDP_LEN_H_P = 0x26,
-        UDP_LEN_L_P = 0x27,
-        UDP_CHECKSUM_H_P = 0x28,
-        UDP_CHECKSUM_L_P = 0x29,
-        UDP_DATA_P = 0x2A,
-
-        // ******* TCP *******
-        //  plain len without the options:
-        TCP_HEADER_LEN_PLAIN = 20,
-
-        TCP_FLAG_FIN_V = 0x01,
-        TCP_FLAGS_FIN_V = 0x01,
-        TCP_FLAGS_SYN_V = 0x02,
-        TCP_FLAG_SYN_V = 0x02,
-        TCP_FLAG_RST_V = 0x04,
-        TCP_FLAG_PUSH_V = 0x08,
-        TCP_FLAGS_ACK_V = 0x10,
-        TCP_FLAG_ACK_V = 0x10,
-        TCP_FLAG_URG_V = 0x20,
-        TCP_FLAG_ECE_V = 0x40,
-        TCP_FLAG_CWR_V = 0x80,
-        TCP_FLAGS_SYNACK_V = 0x12,
-
-        TCP_SRC_PORT_H_P = 0x22,
-        TCP_SRC_PORT_L_P = 0x23,
-        TCP_DST_PORT_H_P = 0x24,
-        TCP_DST_PORT_L_P = 0x25,
-        TCP_SEQ_P = 0x26,    // the tcp seq number is 4 bytes 0x26-0x29
-        TCP_SEQ_H_P = 0x26,
-        TCP_SEQACK_P = 0x2A,    // 4 bytes
-        TCP_SEQACK_H_P = 0x2A,
-        TCP_HEADER_LEN_P = 0x2E,
-        TCP_FLAGS_P = 0x2F,
-        TCP_FLAG_P = 0x2F,
-        TCP_WINDOWSIZE_H_P = 0x30,    // 2 bytes
-        TCP_WINDOWSIZE_L_P = 0x31,
-        TCP_CHECKSUM_H_P = 0x32,
-        TCP_CHECKSUM_L_P = 0x33,
-        TCP_URGENT_PTR_H_P = 0x34,    // 2 bytes
-        TCP_URGENT_PTR_L_P = 0x35,
-        TCP_OPTIONS_P = 0x36,
-        TCP_DATA_P = 0x36
-    };
+    /// Position of IP header in frame (Ethernet II)
+    constexpr size_t IP_P = EthHeader::SIZE;
 
-    enum class PacketType_t { IP, UDP, TCP };
+    /// Position of ICMP, UDP or TCP header (IP header without options)
+    constexpr size_t TRANSPORT_P = IP_P + IpHeader::SIZE;
+
+    /// Maximum length of IP packet in ethernet frame (MTU)
+    constexpr size_t MAX_IP_SIZE = 1500;
 
-    enum Size_t { ETH_HEADER_SIZE = 42 };
+    /// Length of frame check sequence, appended by MAC
+    constexpr size_t CRC_SIZE = 4;
 
-    bool ethTypeIsArp(uint8_t*, size_t, const uint8_t*);
+    /// Maximum length of ethernet frame with its CRC (limit of MAC)
+    constexpr size_t MAX_FRAME_SIZE = EthHeader::SIZE + MAX_IP_SIZE + CRC_SIZE;
 
-    bool ethTypeIsIp(uint8_t*, size_t, const uint8_t*);
+    /// Length of ARP frame (without padding)
+    constexpr size_t ARP_FRAME_SIZE = EthHeader::SIZE + ArpHeader::SIZE;
+
+    /// Head of frame read before classification: headers of ARP, or of IP
+    /// and first 8 bytes of ICMP, UDP or TCP
+    constexpr size_t HEAD_SIZE = TRANSPORT_P + UdpHeader::SIZE;
+
+    enum class PacketType_t { IP, UDP, TCP };
 
-    bool ethTypeIsIcmpEcho(uint8_t*, size_t);
+    /// Protocol of received frame
+    enum class Protocol : uint8_t { OTHER, ARP, ICMP, UDP, TCP };
+
+    /// Result of classification of received frame
+    struct FrameInfo {
+        Protocol protocol;
+        uint16_t key;    ///< ICMP type, destination port of UDP and TCP
+        size_t len;    ///< Length of frame without padding of short frame
+    };
+
+    /**
+     * @brief IP address as 32-bit value, the first byte is most significant
+     *        (the order of packet), so a match is one compare of words
+     */
+    constexpr uint32_t makeIpAddr(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    {
+        return (static_cast<uint32_t>(a) << 24) |
+               (static_cast<uint32_t>(b) << 16) |
+               (static_cast<uint32_t>(c) << 8) | d;
+    }
+
+    /// IP address of multicast group (224.0.0.0/4), see makeIpAddr
+    constexpr bool isMulticastIp(uint32_t ipAddr)
+    {
+        return 0xE0000000 == (ipAddr & 0xF0000000);
+    }
+
+    bool ClassifyFrame(uint8_t*, size_t, uint32_t, FrameInfo*);
 
     void MakeEth(uint8_t*, const uint8_t*);
 
-    void MakeIp(uint8_t*, const uint8_t*);
+    void MakeIp(uint8_t*, uint32_t);
+
+    uint16_t SumWords(const uint8_t*, size_t);
 
     uint16_t CalcCrc(uint8_t*, size_t, PacketType_t);
 
     void FillIpHdrChecksum(uint8_t*);
 
+    void MakeIpFrame(uint8_t*,
+        const uint8_t*,
+        const uint8_t*,
+        uint32_t,
+        uint32_t,
+        uint8_t,
+        size_t,
+        uint16_t);
+
+    uint16_t CalcTransportChecksum(uint8_t*, size_t, PacketType_t);
+
+    uint16_t CalcTransportChecksum(uint8_t*,
+        size_t,
+        size_t,
+        uint16_t,
+        PacketType_t);
+
+    uint16_t UpdateChecksum16(uint16_t, uint16_t, uint16_t);
+
+    uint16_t UpdateChecksum32(uint16_t, uint32_t, uint32_t);
+
+    void RewriteWord16(uint8_t*, uint8_t*, uint16_t);
+
+    void RewriteWord32(uint8_t*, uint8_t*, uint32_t);
+
     size_t MakeArpAnswerFromRequest(uint8_t*,
         size_t,
         const uint8_t*,
-        const uint8_t*);
+        uint32_t);
 
     size_t MakeIcmpEchoAnswerFromRequest(uint8_t*,
         size_t,
         const uint8_t*,
-        const uint8_t*);
+        uint32_t);
 };    // namespace Ethernet
 
 #endif
\ No newline at end of file
@@ -0,0 +1,316 @@
+/**
+ ******************************************************************************
+ * @file    http_server.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the HTTP server of static resources:
+ *          the responses are built by compiler with their checksums,
+ *          so a request costs only the headers of segments.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "http_server.hpp"
+
+namespace {
+    constexpr auto BAD_REQUEST =
+        makeHttpResponse("400 Bad Request", "text/plain", "Bad Request\n");
+
+    constexpr auto NOT_FOUND =
+        makeHttpResponse("404 Not Found", "text/plain", "Not Found\n");
+
+    constexpr auto NOT_IMPLEMENTED = makeHttpResponse(
+        "501 Not Implemented", "text/plain", "Not Implemented\n");
+
+    constexpr HttpResource BAD_REQUEST_RESOURCE(nullptr, BAD_REQUEST);
+
+    constexpr HttpResource NOT_FOUND_RESOURCE(nullptr, NOT_FOUND);
+
+    constexpr HttpResource NOT_IMPLEMENTED_RESOURCE(nullptr, NOT_IMPLEMENTED);
+}
+
+/**
+ * @brief Sum of part of response from prefix sums (one's complement
+ *        subtraction), the part is whole blocks
+ * @param [in] begin - offset of part, on start of block
+ * @param [in] end - end of part, on start of block or end of response
+ * @retval sum of part (see Ethernet::SumWords)
+ */
+uint16_t HttpResource::getSum(size_t begin, size_t end) const
+{
+    const size_t first = begin / blockSize;
+    const size_t last = (end + blockSize - 1) / blockSize;
+    uint32_t sum = sums[last] + static_cast<uint16_t>(~sums[first]);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<uint16_t>(sum);
+}
+
+/**
+ * @brief Constructor
+ * @param [in] stack - protocol stack, its Config::tcpPort is listened
+ * @param [in] resources - table of resources (in flash)
+ * @param [in] resourceCount - size of table
+ */
+HttpServer::HttpServer(NetStack* stack,
+    const HttpResource* resources,
+    size_t resourceCount) :
+    _engine(stack, this),
+    _resources(resources),
+    _resourceCount(resourceCount)
+{
+    for(size_t i = 0; i < TcpEngine::MAX_CONNECTIONS; ++i) {
+        _sessions[i].resource = nullptr;
+        _sessions[i].lineLen = 0;
+    }
+    resetStatistics();
+}
+
+bool HttpServer::listen()
+{
+    return _engine.listen();
+}
+
+void HttpServer::stop()
+{
+    _engine.stop();
+}
+
+/**
+ * @brief Process timers of connections (see TcpEngine::tick())
+ * @param [in] now - time in milliseconds
+ */
+void HttpServer::tick(uint32_t now)
+{
+    _engine.tick(now);
+}
+
+TcpEngine& HttpServer::getEngine()
+{
+    return _engine;
+}
+
+const HttpServer::Statistics& HttpServer::getStatistics() const
+{
+    return _statistics;
+}
+
+void HttpServer::resetStatistics()
+{
+    memset(&_statistics, 0, sizeof(_statistics));
+}
+
+void HttpServer::onConnect(TcpEngine*, TcpConnection* connection)
+{
+    Session* session = &_sessions[connection->getIndex()];
+    session->resource = nullptr;
+    session->offset = 0;
+    session->end = 0;
+    session->lineLen = 0;
+}
+
+/**
+ * @brief Collect request line, the segments of request may split it.
+ *        The header fields after request line are not needed.
+ */
+void HttpServer::onReceive(TcpEngine* engine,
+    TcpConnection* connection,
+    const uint8_t* data,
+    size_t len)
+{
+    Session* session = &_sessions[connection->getIndex()];
+    if(session->resource != nullptr) {
+        return;
+    }
+    for(size_t i = 0; i < len; ++i) {
+        if('\n' == data[i]) {
+            parseRequest(engine, connection, session);
+            return;
+        }
+        if(session->lineLen >= MAX_REQUEST_LINE) {
+            ++_statistics.badRequests;
+            respond(engine, connection, &BAD_REQUEST_RESOURCE, false);
+            return;
+        }
+        session->line[session->lineLen++] = static_cast<char>(data[i]);
+    }
+}
+
+void HttpServer::onSent(TcpEngine* engine, TcpConnection* connection)
+{
+    sendResponse(engine, connection);
+}
+
+/**
+ * @brief The peer has sent request and closed its side: the response
+ *        in progress is finished before own FIN
+ */
+bool HttpServer::onFin(TcpEngine*, TcpConnection* connection)
+{
+    const Session* session = &_sessions[connection->getIndex()];
+    return (nullptr == session->resource) ||
+           (session->offset >= session->end);
+}
+
+void HttpServer::onClose(TcpEngine*, TcpConnection* connection)
+{
+    _sessions[connection->getIndex()].resource = nullptr;
+}
+
+/**
+ * @brief Parse request line "METHOD SP PATH SP HTTP/1.x", then respond
+ * @param [in] engine - engine of connection
+ * @param [in] connection - connection of request
+ * @param [in] session - session of connection with request line
+ */
+void HttpServer::parseRequest(TcpEngine* engine,
+    TcpConnection* connection,
+    Session* session)
+{
+    const char* line = session->line;
+    size_t len = session->lineLen;
+    if((len > 0) && ('\r' == line[len - 1])) {
+        --len;
+    }
+    const char* const end = &line[len];
+
+    const char* path = static_cast<const char*>(memchr(line, ' ', len));
+    const char* version = (nullptr == path) ?
+                              nullptr :
+                              static_cast<const char*>(
+                                  memchr(path + 1, ' ', end - path - 1));
+    if((nullptr == version) || ((end - version - 1) != 8) ||
+        (memcmp(version + 1, "HTTP/1.", 7) != 0)) {
+        ++_statistics.badRequests;
+        respond(engine, connection, &BAD_REQUEST_RESOURCE, false);
+        return;
+    }
+
+    const size_t methodLen = path - line;
+    const bool isHead = (4 == methodLen) && (0 == memcmp(line, "HEAD", 4));
+    const bool isGet = (3 == methodLen) && (0 == memcmp(line, "GET", 3));
+    if(!isGet && !isHead) {
+        ++_statistics.badRequests;
+        respond(engine, connection, &NOT_IMPLEMENTED_RESOURCE, false);
+        return;
+    }
+
+    // the query is not a part of resource
+    ++path;
+    const char* query =
+        static_cast<const char*>(memchr(path, '?', version - path));
+    const HttpResource* resource =
+        findResource(path, ((nullptr == query) ? version : query) - path);
+    if(nullptr == resource) {
+        ++_statistics.notFound;
+        resource = &NOT_FOUND_RESOURCE;
+    }
+    else {
+        ++_statistics.requests;
+    }
+    respond(engine, connection, resource, isHead);
+}
+
+/**
+ * @brief Start response
+ * @param [in] engine - engine of connection
+ * @param [in] connection - connection of request
+ * @param [in] resource - resource of response
+ * @param [in] isHead - only headers are sent
+ */
+void HttpServer::respond(TcpEngine* engine,
+    TcpConnection* connection,
+    const HttpResource* resource,
+    bool isHead)
+{
+    Session* session = &_sessions[connection->getIndex()];
+    session->resource = resource;
+    session->offset = 0;
+    session->end = isHead ? resource->headerLen : resource->size;
+    sendResponse(engine, connection);
+}
+
+/**
+ * @brief Send response while there is send space, then close connection.
+ *        The segments are cut on blocks of response, so the sum of data
+ *        is taken from its prefix sums and the data is only copied.
+ * @param [in] engine - engine of connection
+ * @param [in] connection - connection of response
+ */
+void HttpServer::sendResponse(TcpEngine* engine, TcpConnection* connection)
+{
+    Session* session = &_sessions[connection->getIndex()];
+    const HttpResource* resource = session->resource;
+    if(nullptr == resource) {
+        return;
+    }
+
+    while(session->offset < session->end) {
+        size_t len = engine->getSendSpace(connection);
+        if(0 == len) {
+            return;
+        }
+        const size_t rest = session->end - session->offset;
+        if(len >= rest) {
+            len = rest;
+        }
+        else if(len >= resource->blockSize) {
+            len -= len % resource->blockSize;
+        }
+
+        PacketBuffer* buffer = engine->allocate();
+        if(nullptr == buffer) {
+            return;
+        }
+        memcpy(buffer->payload(), &resource->response[session->offset], len);
+        buffer->len = len;
+
+        // small window or end of headers (HEAD) are not whole blocks
+        const size_t end = session->offset + len;
+        const bool isBlocks =
+            (0 == (session->offset % resource->blockSize)) &&
+            ((0 == (end % resource->blockSize)) || (end == resource->size));
+        const bool isSent = isBlocks ?
+                                engine->sendBuffer(connection,
+                                    buffer,
+                                    resource->getSum(session->offset, end)) :
+                                engine->sendBuffer(connection, buffer);
+        if(!isSent) {
+            engine->getStack()->getPool()->release(buffer);
+            return;
+        }
+        if(isBlocks) {
+            ++_statistics.precomputed;
+        }
+        else {
+            ++_statistics.summed;
+        }
+        session->offset = end;
+    }
+    engine->close(connection);
+}
+
+/**
+ * @brief Find resource of path
+ * @param [in] path - path of request (not terminated by zero)
+ * @param [in] len - length of path
+ * @retval pointer on resource, nullptr if it is not found
+ */
+const HttpResource* HttpServer::findResource(const char* path,
+    size_t len) const
+{
+    for(size_t i = 0; i < _resourceCount; ++i) {
+        const HttpResource* resource = &_resources[i];
+        if((strlen(resource->path) == len) &&
+            (0 == memcmp(resource->path, path, len))) {
+            return resource;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,273 @@
+/**
+ ******************************************************************************
+ * @file    http_server.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the HTTP server of static resources:
+ *          the responses are built by compiler with their checksums,
+ *          so a request costs only the headers of segments.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HTTP_SERVER_HPP
+#define __HTTP_SERVER_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "tcp_engine.hpp"
+
+namespace Http {
+    /// Length of text, for compiler
+    constexpr size_t getTextLen(const char* text)
+    {
+        size_t len = 0;
+        while(text[len] != '\0') {
+            ++len;
+        }
+        return len;
+    }
+
+    /// Decimal digits of value, for compiler
+    constexpr size_t getDigits(size_t value)
+    {
+        size_t digits = 1;
+        while(value >= 10) {
+            value /= 10;
+            ++digits;
+        }
+        return digits;
+    }
+};    // namespace Http
+
+/**
+ * @brief Static HTTP response: status line, headers and content are
+ *        written by compiler, with prefix sums of its blocks for TCP
+ *        checksum (see HttpResource). Use makeHttpResponse().
+ * @tparam STATUS_LEN - length of status (e.g. "200 OK")
+ * @tparam TYPE_LEN - length of content type
+ * @tparam CONTENT_LEN - length of content
+ */
+template<size_t STATUS_LEN, size_t TYPE_LEN, size_t CONTENT_LEN>
+class HttpStaticResponse {
+  public:
+    /// Sum of data is kept per block, so a segment of whole blocks is
+    /// summed by one subtraction (the block is even)
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    static constexpr size_t HEADER_LEN =
+        Http::getTextLen("HTTP/1.1 ") + STATUS_LEN +
+        Http::getTextLen("\r\nContent-Type: ") + TYPE_LEN +
+        Http::getTextLen("\r\nContent-Length: ") +
+        Http::getDigits(CONTENT_LEN) +
+        Http::getTextLen("\r\nConnection: close\r\n\r\n");
+
+    static constexpr size_t SIZE = HEADER_LEN + CONTENT_LEN;
+
+    static constexpr size_t BLOCKS = (SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    constexpr HttpStaticResponse(const char* status,
+        const char* type,
+        const char* content) :
+        _data{},
+        _sums{}
+    {
+        size_t pos = append(0, "HTTP/1.1 ");
+        pos = append(pos, status, STATUS_LEN);
+        pos = append(pos, "\r\nContent-Type: ");
+        pos = append(pos, type, TYPE_LEN);
+        pos = append(pos, "\r\nContent-Length: ");
+        size_t value = CONTENT_LEN;
+        for(size_t i = Http::getDigits(CONTENT_LEN); i > 0; --i) {
+            _data[pos + i - 1] = '0' + (value % 10);
+            value /= 10;
+        }
+        pos += Http::getDigits(CONTENT_LEN);
+        pos = append(pos, "\r\nConnection: close\r\n\r\n");
+        append(pos, content, CONTENT_LEN);
+
+        // big-endian words, the odd byte at end is padded with zero
+        uint32_t sum = 0;
+        for(size_t block = 0; block < BLOCKS; ++block) {
+            for(size_t i = block * BLOCK_SIZE;
+                (i < ((block + 1) * BLOCK_SIZE)) && (i < SIZE);
+                i += 2) {
+                sum += static_cast<uint32_t>(_data[i]) << 8;
+                sum += ((i + 1) < SIZE) ? _data[i + 1] : 0;
+            }
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            _sums[block + 1] = static_cast<uint16_t>(sum);
+        }
+    }
+
+    constexpr const uint8_t* getData() const
+    {
+        return _data;
+    }
+
+    constexpr const uint16_t* getSums() const
+    {
+        return _sums;
+    }
+
+  private:
+    constexpr size_t append(size_t pos, const char* text, size_t len)
+    {
+        for(size_t i = 0; i < len; ++i) {
+            _data[pos + i] = static_cast<uint8_t>(text[i]);
+        }
+        return pos + len;
+    }
+
+    constexpr size_t append(size_t pos, const char* text)
+    {
+        return append(pos, text, Http::getTextLen(text));
+    }
+
+    uint8_t _data[SIZE];
+
+    uint16_t _sums[BLOCKS + 1];    ///< Sum of first blocks, _sums[0] = 0
+};
+
+/**
+ * @brief Build static response, the lengths are taken from literals
+ * @param [in] status - status of response (e.g. "200 OK")
+ * @param [in] type - content type (e.g. "text/html")
+ * @param [in] content - content (the terminating zero is not sent)
+ */
+template<size_t STATUS_SIZE, size_t TYPE_SIZE, size_t CONTENT_SIZE>
+constexpr HttpStaticResponse<STATUS_SIZE - 1, TYPE_SIZE - 1, CONTENT_SIZE - 1>
+    makeHttpResponse(const char (&status)[STATUS_SIZE],
+        const char (&type)[TYPE_SIZE],
+        const char (&content)[CONTENT_SIZE])
+{
+    return HttpStaticResponse<STATUS_SIZE - 1, TYPE_SIZE - 1, CONTENT_SIZE - 1>(
+        status, type, content);
+}
+
+/**
+ * @brief Resource of HTTP server: path and its static response in flash
+ */
+struct HttpResource {
+    const char* path;    ///< Absolute path without query (e.g. "/")
+
+    const uint8_t* response;    ///< Headers and content
+
+    size_t size;    ///< Length of response
+
+    size_t headerLen;    ///< Length of headers (response to HEAD)
+
+    size_t blockSize;
+
+    const uint16_t* sums;    ///< Prefix sums of blocks of response
+
+    template<size_t STATUS_LEN, size_t TYPE_LEN, size_t CONTENT_LEN>
+    constexpr HttpResource(const char* resourcePath,
+        const HttpStaticResponse<STATUS_LEN, TYPE_LEN, CONTENT_LEN>& source) :
+        path(resourcePath),
+        response(source.getData()),
+        size(source.SIZE),
+        headerLen(source.HEADER_LEN),
+        blockSize(source.BLOCK_SIZE),
+        sums(source.getSums())
+    {
+    }
+
+    uint16_t getSum(size_t, size_t) const;
+};
+
+/**
+ * @brief Class of HTTP/1.0 and HTTP/1.1 server on TCP port of stack.
+ *        The request line is parsed (GET and HEAD), its resource is sent
+ *        from flash in segments of whole blocks, so the checksum of data
+ *        is taken from prefix sums, then the connection is closed.
+ */
+class HttpServer final
+    : private NonCopyable<HttpServer>
+    , private NonMovable<HttpServer>
+    , public TcpApplication {
+  public:
+    /// Maximum of request line, the longer request is bad
+    static constexpr size_t MAX_REQUEST_LINE = 64;
+
+    struct Statistics {
+        uint32_t requests;    ///< Found resources
+        uint32_t notFound;
+        uint32_t badRequests;    ///< Too long, invalid or unknown method
+        uint32_t precomputed;    ///< Segments with sum of blocks
+        uint32_t summed;    ///< Segments with summed data (not whole blocks)
+    };
+
+    HttpServer(NetStack*, const HttpResource*, size_t);
+
+    bool listen();
+
+    void stop();
+
+    void tick(uint32_t);
+
+    TcpEngine& getEngine();
+
+    const Statistics& getStatistics() const;
+
+    void resetStatistics();
+
+    void onConnect(TcpEngine*, TcpConnection*) override;
+
+    void onReceive(TcpEngine*,
+        TcpConnection*,
+        const uint8_t*,
+        size_t) override;
+
+    void onSent(TcpEngine*, TcpConnection*) override;
+
+    bool onFin(TcpEngine*, TcpConnection*) override;
+
+    void onClose(TcpEngine*, TcpConnection*) override;
+
+  private:
+    /// Request of connection, then its response
+    struct Session {
+        const HttpResource* resource;    ///< nullptr - request is not read
+        size_t offset;    ///< Next sent byte of response
+        size_t end;    ///< End of sent part of response
+        size_t lineLen;
+        char line[MAX_REQUEST_LINE];    ///< Request line without CRLF
+    };
+
+    HttpServer() = delete;
+
+    void parseRequest(TcpEngine*, TcpConnection*, Session*);
+
+    void respond(TcpEngine*, TcpConnection*, const HttpResource*, bool);
+
+    void sendResponse(TcpEngine*, TcpConnection*);
+
+    const HttpResource* findResource(const char*, size_t) const;
+
+    TcpEngine _engine;
+
+    const HttpResource* const _resources;
+
+    const size_t _resourceCount;
+
+    Session _sessions[TcpEngine::MAX_CONNECTIONS];
+
+    Statistics _statistics;
+};
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ ******************************************************************************
+ * @file    instrumentation.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the per-frame counters of ENC28J60 driver.
+ *          The counters are compiled only with ENC28J60_INSTRUMENTATION
+ *          defined, otherwise all methods are empty.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __INSTRUMENTATION_HPP
+#define __INSTRUMENTATION_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycle_counter.hpp"
+
+/**
+ * @brief Counters of processing per type of frame
+ */
+struct Instrumentation {
+    enum FrameType {
+        FRAME_ARP,
+        FRAME_ICMP,
+        FRAME_UDP,
+        FRAME_TCP,
+        FRAME_DROPPED,
+        FRAME_OTHER,
+        FRAME_TYPES
+    };
+
+    enum Stage {
+        STAGE_RECEIVE,    ///< receive of device
+        STAGE_CLASSIFY,    ///< check of headers
+        STAGE_REPLY,    ///< building of answer
+        STAGE_SEND,    ///< send and sendReply of device
+        STAGES
+    };
+
+    struct Counters {
+        uint32_t frames;
+        uint32_t bytes;
+        uint32_t spiTransactions;
+        uint32_t bankSwitches;
+        uint32_t cycles[STAGES];
+    };
+
+    Counters frame[FRAME_TYPES];
+};
+
+/**
+ * @brief Class collecting the counters of current frame and adding them
+ *        to its type when the frame is classified
+ */
+class Profiler {
+  public:
+#ifdef ENC28J60_INSTRUMENTATION
+    Profiler() : _start(0)
+    {
+        CycleCounter::enable();
+        reset();
+    }
+
+    void reset()
+    {
+        memset(&_total, 0, sizeof(_total));
+        discard();
+    }
+
+    void spiTransaction()
+    {
+        ++_current.spiTransactions;
+    }
+
+    void bankSwitch()
+    {
+        ++_current.bankSwitches;
+    }
+
+    void begin(Instrumentation::Stage)
+    {
+        _start = CycleCounter::now();
+    }
+
+    void end(Instrumentation::Stage stage)
+    {
+        _current.cycles[stage] += CycleCounter::now() - _start;
+    }
+
+    /**
+     * @brief Add the counters of current frame to its type
+     * @param [in] type - type of frame
+     * @param [in] bytes - length of frame
+     */
+    void commit(Instrumentation::FrameType type, size_t bytes)
+    {
+        Instrumentation::Counters& counters = _total.frame[type];
+        ++counters.frames;
+        counters.bytes += bytes;
+        counters.spiTransactions += _current.spiTransactions;
+        counters.bankSwitches += _current.bankSwitches;
+        for(size_t i = 0; i < Instrumentation::STAGES; ++i) {
+            counters.cycles[i] += _current.cycles[i];
+        }
+        discard();
+    }
+
+    /**
+     * @brief Drop the counters of current frame (poll without frame)
+     */
+    void discard()
+    {
+        memset(&_current, 0, sizeof(_current));
+    }
+
+    const Instrumentation& get() const
+    {
+        return _total;
+    }
+
+  private:
+    Instrumentation _total;
+
+    Instrumentation::Counters _current;
+
+    uint32_t _start;
+#else
+    void reset() {}
+
+    void spiTransaction() {}
+
+    void bankSwitch() {}
+
+    void begin(Instrumentation::Stage) {}
+
+    void end(Instrumentation::Stage) {}
+
+    void commit(Instrumentation::FrameType, size_t) {}
+
+    void discard() {}
+#endif
+};
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @file    net_config.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the compile-time configuration of network
+ *          interface: addresses and sizes of buffers are checked by compiler.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NET_CONFIG_HPP
+#define __NET_CONFIG_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "enc28j60.hpp"
+#include "net_stack.hpp"
+#include "packet_pool.hpp"
+#include "tcp_engine.hpp"
+
+/**
+ * @brief Configuration of network interface
+ * @tparam MAC_ADDR - MAC address, the first byte is most significant
+ *                    (0x002F6812AC30 is 00:2F:68:12:AC:30)
+ * @tparam IP_ADDR - IP address, see Ethernet::makeIpAddr
+ * @tparam TCP_PORT - port of TCP server
+ * @tparam TX_SLOTS - TX slots at end of SRAM of ENC28J60
+ * @tparam TX_SLOT_SIZE - size of TX slot
+ * @tparam POLL_BUDGET - maximum frames processed by one poll()
+ * @tparam BUFFER_COUNT - frame buffers of pool of stack
+ */
+template<uint64_t MAC_ADDR,
+    uint32_t IP_ADDR,
+    uint16_t TCP_PORT,
+    uint8_t TX_SLOTS = 2,
+    uint16_t TX_SLOT_SIZE = 0x0600,
+    size_t POLL_BUDGET = NetStack::POLL_BUDGET,
+    size_t BUFFER_COUNT = PacketPool::BUFFER_COUNT>
+struct NetConfig {
+    static_assert(MAC_ADDR < (1ULL << 48), "MAC address is 48-bit");
+    static_assert(!((MAC_ADDR >> 40) & 0x01),
+        "MAC address must be unicast");
+    static_assert(MAC_ADDR != 0, "MAC address must be set");
+    static_assert((IP_ADDR != 0) && (IP_ADDR != 0xFFFFFFFF),
+        "IP address must be host address");
+    static_assert(TCP_PORT != 0, "TCP port must be set");
+    static_assert(Enc28j60::isValidPartition(TX_SLOTS, TX_SLOT_SIZE),
+        "TX slots must leave full frame for RX ring");
+    static_assert(POLL_BUDGET > 0, "Poll budget must be positive");
+    static_assert(BUFFER_COUNT > TcpEngine::RETRANSMIT_SLOTS,
+        "Pool must have buffer for received frame");
+
+    static constexpr uint64_t macAddr = MAC_ADDR;
+    static constexpr uint32_t ipAddr = IP_ADDR;
+    static constexpr uint16_t tcpPort = TCP_PORT;
+    static constexpr uint8_t txSlots = TX_SLOTS;
+    static constexpr uint16_t txSlotSize = TX_SLOT_SIZE;
+    static constexpr size_t pollBudget = POLL_BUDGET;
+    static constexpr size_t bufferCount = BUFFER_COUNT;
+
+    /**
+     * @brief Byte of MAC address in order of packet
+     * @param [in] index - index of byte (0 - first byte of packet)
+     */
+    static constexpr uint8_t getMacByte(size_t index)
+    {
+        return (MAC_ADDR >> (8 * (NetDevice::MAC_ADDR_SIZE - 1 - index))) &
+               0xFF;
+    }
+};
+
+#endif
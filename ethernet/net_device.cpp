@@ -0,0 +1,24 @@
+/**
+ ******************************************************************************
+ * @file    net_device.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the default methods of network device.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "net_device.hpp"
+#include "ethernet.hpp"
+
+bool NetDevice::isValidChecksum(uint8_t* frame, size_t offset, size_t len)
+{
+    return 0 ==
+           Ethernet::CalcCrc(&frame[offset], len, Ethernet::PacketType_t::IP);
+}
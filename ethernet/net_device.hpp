@@ -0,0 +1,130 @@
+/**
+ ******************************************************************************
+ * @file    net_device.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the interface of network device (frames in
+ *          and out), the protocols are handled by NetStack.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NET_DEVICE_HPP
+#define __NET_DEVICE_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "instrumentation.hpp"
+
+/**
+ * @brief Interface of network device.
+ *        The device may keep the received frame until the next receive()
+ *        (lazy receive): only its head is read, the rest is read by fetch(),
+ *        checked by isValidChecksum() and copied into reply by sendReply()
+ *        inside the device. The default methods are for devices which
+ *        receive the whole frame into buffer.
+ */
+class NetDevice {
+  public:
+    static constexpr size_t IP_ADDR_SIZE = 4;
+    static constexpr size_t MAC_ADDR_SIZE = 6;
+
+    virtual ~NetDevice() = default;
+
+    /**
+     * @brief Receive next frame, the previous frame is dropped
+     * @param [out] frame - buffer of frame, at least head of frame is read
+     * @param [in] maxLen - size of buffer
+     * @retval length of frame, zero if there is no frame
+     */
+    virtual size_t receive(uint8_t* frame, size_t maxLen) = 0;
+
+    /**
+     * @brief Send frame
+     * @param [in] frame - pointer on frame
+     * @param [in] len - length of frame
+     */
+    virtual void send(const uint8_t* frame, size_t len) = 0;
+
+    virtual bool isLinkUp() = 0;
+
+    virtual const uint8_t* getMacAddr() const = 0;
+
+    /**
+     * @brief Read the rest of received frame after its head
+     * @param [out] frame - buffer of frame, the head is already there
+     */
+    virtual void fetch(uint8_t* frame)
+    {
+        (void)frame;
+    }
+
+    /**
+     * @brief Check checksum of part of received frame, the checksum field
+     *        is inside the part
+     * @param [in,out] frame - buffer of frame, the part is fetched into it
+     *                 if it was not read yet
+     * @param [in] offset - offset of part in frame
+     * @param [in] len - length of part
+     * @retval true - checksum is valid
+     */
+    virtual bool isValidChecksum(uint8_t* frame,
+        size_t offset,
+        size_t len);
+
+    /**
+     * @brief Send reply to received frame: the head of reply is in buffer,
+     *        the rest is the same as in received frame (at the same offset)
+     * @param [in] frame - buffer of frame, its head is changed for reply
+     * @param [in] headLen - length of head
+     * @param [in] len - length of reply
+     * @param [in] checksumStart - start of checksummed part of reply,
+     *             zero - the part has not checksum
+     * @param [in] checksumPos - position of checksum (inside head), the
+     *             checksum of head is valid, the device may recompute it
+     */
+    virtual void sendReply(uint8_t* frame,
+        size_t headLen,
+        size_t len,
+        size_t checksumStart,
+        size_t checksumPos)
+    {
+        (void)headLen;
+        (void)checksumStart;
+        (void)checksumPos;
+        send(frame, len);
+    }
+
+    /**
+     * @brief Counters of current frame, shared by device and stack
+     */
+    Profiler& getProfiler()
+    {
+        return _profiler;
+    }
+
+#ifdef ENC28J60_INSTRUMENTATION
+    const Instrumentation& getInstrumentation() const
+    {
+        return _profiler.get();
+    }
+
+    void resetInstrumentation()
+    {
+        _profiler.reset();
+    }
+#endif
+
+  protected:
+    Profiler _profiler;
+};
+
+#endif
@@ -0,0 +1,617 @@
+/**
+ ******************************************************************************
+ * @file    net_headers.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the typed views of protocol headers
+ *          (Ethernet, ARP, IPv4, ICMP, UDP, TCP) over frame buffer.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NET_HEADERS_HPP
+#define __NET_HEADERS_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ICCARM__)
+#include <intrinsics.h>
+#endif
+
+#if (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)) || \
+    (defined(__LITTLE_ENDIAN__) && (__LITTLE_ENDIAN__ == 0))
+#define NET_BIG_ENDIAN 1
+#else
+#define NET_BIG_ENDIAN 0
+#endif
+
+namespace Ethernet {
+    /// Byte order of packet to byte order of CPU and back
+    inline uint16_t swapBytes16(uint16_t value)
+    {
+#if NET_BIG_ENDIAN
+        return value;
+#elif defined(__ICCARM__)
+        return static_cast<uint16_t>(__REV16(value));
+#else
+        return __builtin_bswap16(value);
+#endif
+    }
+
+    inline uint32_t swapBytes32(uint32_t value)
+    {
+#if NET_BIG_ENDIAN
+        return value;
+#elif defined(__ICCARM__)
+        return __REV(value);
+#else
+        return __builtin_bswap32(value);
+#endif
+    }
+
+    /**
+     * @brief Big-endian 16-bit field of packet, one load of word
+     *        (Cortex-M3 loads halfword on any address)
+     */
+    inline uint16_t getWord16(const uint8_t* buf)
+    {
+        uint16_t value;
+        memcpy(&value, buf, sizeof(value));
+        return swapBytes16(value);
+    }
+
+    inline void putWord16(uint8_t* buf, uint16_t value)
+    {
+        value = swapBytes16(value);
+        memcpy(buf, &value, sizeof(value));
+    }
+
+    /// Big-endian 32-bit field of packet
+    inline uint32_t getWord32(const uint8_t* buf)
+    {
+        uint32_t value;
+        memcpy(&value, buf, sizeof(value));
+        return swapBytes32(value);
+    }
+
+    inline void putWord32(uint8_t* buf, uint32_t value)
+    {
+        value = swapBytes32(value);
+        memcpy(buf, &value, sizeof(value));
+    }
+
+    /**
+     * @brief Field of header by type, the conversion of byte order
+     *        is selected at compile time
+     */
+    template<typename T>
+    struct Field;
+
+    template<>
+    struct Field<uint8_t> {
+        static uint8_t get(const uint8_t* buf)
+        {
+            return *buf;
+        }
+
+        static void set(uint8_t* buf, uint8_t value)
+        {
+            *buf = value;
+        }
+    };
+
+    template<>
+    struct Field<uint16_t> {
+        static uint16_t get(const uint8_t* buf)
+        {
+            return getWord16(buf);
+        }
+
+        static void set(uint8_t* buf, uint16_t value)
+        {
+            putWord16(buf, value);
+        }
+    };
+
+    template<>
+    struct Field<uint32_t> {
+        static uint32_t get(const uint8_t* buf)
+        {
+            return getWord32(buf);
+        }
+
+        static void set(uint8_t* buf, uint32_t value)
+        {
+            putWord32(buf, value);
+        }
+    };
+
+    /**
+     * @brief View of header in frame buffer, it does not own the buffer.
+     *        The positions of fields are template arguments, so access
+     *        is compiled to loads at constant offset.
+     */
+    class HeaderView {
+      public:
+        explicit HeaderView(uint8_t* buf) : _buf(buf) {}
+
+        uint8_t* data() const
+        {
+            return _buf;
+        }
+
+      protected:
+        template<typename T, size_t POS>
+        T get() const
+        {
+            return Field<T>::get(_buf + POS);
+        }
+
+        template<typename T, size_t POS>
+        void set(T value)
+        {
+            Field<T>::set(_buf + POS, value);
+        }
+
+        uint8_t* const _buf;
+    };
+
+    /**
+     * @brief Ethernet II header
+     */
+    class EthHeader : public HeaderView {
+      public:
+        enum Position : uint8_t { DST_MAC = 0, SRC_MAC = 6, TYPE = 12 };
+
+        enum Type : uint16_t { TYPE_IP = 0x0800, TYPE_ARP = 0x0806 };
+
+        static constexpr size_t SIZE = 14;
+
+        using HeaderView::HeaderView;
+
+        uint8_t* getDstMac() const
+        {
+            return _buf + DST_MAC;
+        }
+
+        uint8_t* getSrcMac() const
+        {
+            return _buf + SRC_MAC;
+        }
+
+        uint16_t getType() const
+        {
+            return get<uint16_t, TYPE>();
+        }
+
+        void setType(uint16_t value)
+        {
+            set<uint16_t, TYPE>(value);
+        }
+    };
+
+    /**
+     * @brief ARP header for IPv4 over Ethernet
+     */
+    class ArpHeader : public HeaderView {
+      public:
+        enum Position : uint8_t {
+            HARDWARE_TYPE = 0,
+            PROTOCOL = 2,
+            HARDWARE_SIZE = 4,
+            PROTOCOL_SIZE = 5,
+            OPCODE = 6,
+            SRC_MAC = 8,
+            SRC_IP = 14,
+            DST_MAC = 18,
+            DST_IP = 24
+        };
+
+        enum Opcode : uint16_t { OPCODE_REQUEST = 1, OPCODE_REPLY = 2 };
+
+        static constexpr size_t SIZE = 28;
+
+        using HeaderView::HeaderView;
+
+        uint16_t getOpcode() const
+        {
+            return get<uint16_t, OPCODE>();
+        }
+
+        void setOpcode(uint16_t value)
+        {
+            set<uint16_t, OPCODE>(value);
+        }
+
+        uint8_t* getSrcMac() const
+        {
+            return _buf + SRC_MAC;
+        }
+
+        uint8_t* getDstMac() const
+        {
+            return _buf + DST_MAC;
+        }
+
+        uint32_t getSrcIp() const
+        {
+            return get<uint32_t, SRC_IP>();
+        }
+
+        void setSrcIp(uint32_t value)
+        {
+            set<uint32_t, SRC_IP>(value);
+        }
+
+        uint32_t getDstIp() const
+        {
+            return get<uint32_t, DST_IP>();
+        }
+
+        void setDstIp(uint32_t value)
+        {
+            set<uint32_t, DST_IP>(value);
+        }
+    };
+
+    /**
+     * @brief IPv4 header without options
+     */
+    class IpHeader : public HeaderView {
+      public:
+        enum Position : uint8_t {
+            VER_LEN = 0,
+            TOS = 1,
+            TOTAL_LEN = 2,
+            ID = 4,
+            FLAGS = 6,
+            TTL = 8,
+            PROTOCOL = 9,
+            CHECKSUM = 10,
+            SRC_IP = 12,
+            DST_IP = 16
+        };
+
+        enum Protocol : uint8_t {
+            PROTOCOL_ICMP = 0x01,
+            PROTOCOL_TCP = 0x06,
+            PROTOCOL_UDP = 0x11
+        };
+
+        static constexpr size_t SIZE = 20;
+
+        /// IP V4 and 20 byte header
+        static constexpr uint8_t VER_LEN_V4 = 0x45;
+
+        /// Don't fragment, fragment offset is zero
+        static constexpr uint16_t FLAGS_DONT_FRAGMENT = 0x4000;
+
+        static constexpr uint8_t DEFAULT_TTL = 64;
+
+        using HeaderView::HeaderView;
+
+        uint8_t getVerLen() const
+        {
+            return get<uint8_t, VER_LEN>();
+        }
+
+        void setVerLen(uint8_t value)
+        {
+            set<uint8_t, VER_LEN>(value);
+        }
+
+        uint16_t getTotalLen() const
+        {
+            return get<uint16_t, TOTAL_LEN>();
+        }
+
+        void setTotalLen(uint16_t value)
+        {
+            set<uint16_t, TOTAL_LEN>(value);
+        }
+
+        uint16_t getId() const
+        {
+            return get<uint16_t, ID>();
+        }
+
+        void setId(uint16_t value)
+        {
+            set<uint16_t, ID>(value);
+        }
+
+        uint16_t getFlags() const
+        {
+            return get<uint16_t, FLAGS>();
+        }
+
+        void setFlags(uint16_t value)
+        {
+            set<uint16_t, FLAGS>(value);
+        }
+
+        uint8_t getTtl() const
+        {
+            return get<uint8_t, TTL>();
+        }
+
+        void setTtl(uint8_t value)
+        {
+            set<uint8_t, TTL>(value);
+        }
+
+        uint8_t getProtocol() const
+        {
+            return get<uint8_t, PROTOCOL>();
+        }
+
+        void setProtocol(uint8_t value)
+        {
+            set<uint8_t, PROTOCOL>(value);
+        }
+
+        uint16_t getChecksum() const
+        {
+            return get<uint16_t, CHECKSUM>();
+        }
+
+        void setChecksum(uint16_t value)
+        {
+            set<uint16_t, CHECKSUM>(value);
+        }
+
+        uint32_t getSrcIp() const
+        {
+            return get<uint32_t, SRC_IP>();
+        }
+
+        void setSrcIp(uint32_t value)
+        {
+            set<uint32_t, SRC_IP>(value);
+        }
+
+        uint32_t getDstIp() const
+        {
+            return get<uint32_t, DST_IP>();
+        }
+
+        void setDstIp(uint32_t value)
+        {
+            set<uint32_t, DST_IP>(value);
+        }
+    };
+
+    /**
+     * @brief ICMP echo header
+     */
+    class IcmpHeader : public HeaderView {
+      public:
+        enum Position : uint8_t {
+            TYPE = 0,
+            CODE = 1,
+            CHECKSUM = 2,
+            ID = 4,
+            SEQUENCE = 6
+        };
+
+        enum Type : uint8_t { TYPE_ECHO_REPLY = 0, TYPE_ECHO_REQUEST = 8 };
+
+        static constexpr size_t SIZE = 8;
+
+        using HeaderView::HeaderView;
+
+        uint8_t getType() const
+        {
+            return get<uint8_t, TYPE>();
+        }
+
+        uint8_t getCode() const
+        {
+            return get<uint8_t, CODE>();
+        }
+
+        uint16_t getChecksum() const
+        {
+            return get<uint16_t, CHECKSUM>();
+        }
+
+        void setChecksum(uint16_t value)
+        {
+            set<uint16_t, CHECKSUM>(value);
+        }
+    };
+
+    /**
+     * @brief UDP header
+     */
+    class UdpHeader : public HeaderView {
+      public:
+        enum Position : uint8_t {
+            SRC_PORT = 0,
+            DST_PORT = 2,
+            LEN = 4,
+            CHECKSUM = 6
+        };
+
+        static constexpr size_t SIZE = 8;
+
+        using HeaderView::HeaderView;
+
+        uint16_t getSrcPort() const
+        {
+            return get<uint16_t, SRC_PORT>();
+        }
+
+        void setSrcPort(uint16_t value)
+        {
+            set<uint16_t, SRC_PORT>(value);
+        }
+
+        uint16_t getDstPort() const
+        {
+            return get<uint16_t, DST_PORT>();
+        }
+
+        void setDstPort(uint16_t value)
+        {
+            set<uint16_t, DST_PORT>(value);
+        }
+
+        uint16_t getLen() const
+        {
+            return get<uint16_t, LEN>();
+        }
+
+        void setLen(uint16_t value)
+        {
+            set<uint16_t, LEN>(value);
+        }
+
+        uint16_t getChecksum() const
+        {
+            return get<uint16_t, CHECKSUM>();
+        }
+
+        void setChecksum(uint16_t value)
+        {
+            set<uint16_t, CHECKSUM>(value);
+        }
+    };
+
+    /**
+     * @brief TCP header, the options follow it up to data offset
+     */
+    class TcpHeader : public HeaderView {
+      public:
+        enum Position : uint8_t {
+            SRC_PORT = 0,
+            DST_PORT = 2,
+            SEQUENCE = 4,
+            ACKNOWLEDGE = 8,
+            DATA_OFFSET = 12,
+            FLAGS = 13,
+            WINDOW = 14,
+            CHECKSUM = 16,
+            URGENT_PTR = 18,
+            OPTIONS = 20
+        };
+
+        enum Flag : uint8_t {
+            FLAG_FIN = 0x01,
+            FLAG_SYN = 0x02,
+            FLAG_RST = 0x04,
+            FLAG_PUSH = 0x08,
+            FLAG_ACK = 0x10,
+            FLAG_URG = 0x20,
+            FLAG_ECE = 0x40,
+            FLAG_CWR = 0x80
+        };
+
+        /// Plain length without the options
+        static constexpr size_t SIZE = 20;
+
+        using HeaderView::HeaderView;
+
+        uint16_t getSrcPort() const
+        {
+            return get<uint16_t, SRC_PORT>();
+        }
+
+        void setSrcPort(uint16_t value)
+        {
+            set<uint16_t, SRC_PORT>(value);
+        }
+
+        uint16_t getDstPort() const
+        {
+            return get<uint16_t, DST_PORT>();
+        }
+
+        void setDstPort(uint16_t value)
+        {
+            set<uint16_t, DST_PORT>(value);
+        }
+
+        uint32_t getSequence() const
+        {
+            return get<uint32_t, SEQUENCE>();
+        }
+
+        void setSequence(uint32_t value)
+        {
+            set<uint32_t, SEQUENCE>(value);
+        }
+
+        uint32_t getAcknowledge() const
+        {
+            return get<uint32_t, ACKNOWLEDGE>();
+        }
+
+        void setAcknowledge(uint32_t value)
+        {
+            set<uint32_t, ACKNOWLEDGE>(value);
+        }
+
+        /// Length of header with options
+        size_t getHeaderLen() const
+        {
+            return (get<uint8_t, DATA_OFFSET>() >> 4) * 4;
+        }
+
+        void setHeaderLen(size_t len)
+        {
+            set<uint8_t, DATA_OFFSET>((len / 4) << 4);
+        }
+
+        uint8_t getFlags() const
+        {
+            return get<uint8_t, FLAGS>();
+        }
+
+        void setFlags(uint8_t value)
+        {
+            set<uint8_t, FLAGS>(value);
+        }
+
+        uint16_t getWindow() const
+        {
+            return get<uint16_t, WINDOW>();
+        }
+
+        void setWindow(uint16_t value)
+        {
+            set<uint16_t, WINDOW>(value);
+        }
+
+        uint16_t getChecksum() const
+        {
+            return get<uint16_t, CHECKSUM>();
+        }
+
+        void setChecksum(uint16_t value)
+        {
+            set<uint16_t, CHECKSUM>(value);
+        }
+
+        uint16_t getUrgentPtr() const
+        {
+            return get<uint16_t, URGENT_PTR>();
+        }
+
+        void setUrgentPtr(uint16_t value)
+        {
+            set<uint16_t, URGENT_PTR>(value);
+        }
+    };
+};    // namespace Ethernet
+
+#endif
@@ -0,0 +1,317 @@
+/**
+ ******************************************************************************
+ * @file    net_stack.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the protocol handling over network device:
+ *          classification of frames and dispatch to registered handlers.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "net_stack.hpp"
+
+/**
+ * @brief Constructor
+ * @param [in] device - network device
+ * @param [in] pool - pool of frame buffers
+ * @param [in] config - configuration of stack
+ */
+NetStack::NetStack(NetDevice* device,
+    PacketPool* pool,
+    const Config* config) :
+    _device(device),
+    _pool(pool),
+    _tcpPort(config->tcpPort),
+    _ipAddr(config->ipAddr),
+    _ipId(IP_IDENTIFIER),
+    _pollBudget(config->pollBudget),
+    _handlerCount(0)
+{
+    for(size_t i = 0; i < HANDLER_SLOTS; ++i) {
+        _handlers[i].handler = nullptr;
+    }
+    addHandler(Ethernet::Protocol::ARP, 0, &_arpResponder);
+    addHandler(Ethernet::Protocol::ICMP,
+        Ethernet::IcmpHeader::TYPE_ECHO_REQUEST,
+        &_echoResponder);
+}
+
+/**
+ * @brief Process the received frames, calling from main loop
+ * @retval number of processed frames (not more than poll budget),
+ *         the frames stay in device while the pool is empty
+ */
+size_t NetStack::poll()
+{
+    Profiler& profiler = _device->getProfiler();
+    // the operations out of frames are not counted
+    profiler.discard();
+
+    size_t processed = 0;
+    while(processed < _pollBudget) {
+        // the ethernet header is outermost, the headroom only aligns
+        // IP header on word, its fields are loaded by words
+        PacketBuffer* buffer = _pool->allocate(RX_HEADROOM);
+        if(nullptr == buffer) {
+            break;
+        }
+
+        profiler.begin(Instrumentation::STAGE_RECEIVE);
+        buffer->len =
+            _device->receive(buffer->payload(), buffer->tailroom());
+        profiler.end(Instrumentation::STAGE_RECEIVE);
+        if(0 == buffer->len) {
+            _pool->release(buffer);
+            profiler.discard();
+            break;
+        }
+        handlePacket(buffer);
+        _pool->release(buffer);
+        ++processed;
+    }
+    return processed;
+}
+
+/**
+ * @brief Register handler of frames, the handler of the same protocol
+ *        and key is replaced
+ * @param [in] protocol - protocol of frames
+ * @param [in] key - ICMP type, UDP or TCP port, zero for ARP
+ * @param [in] handler - pointer on handler
+ * @retval true - handler is registered, false - table is full
+ */
+bool NetStack::addHandler(Ethernet::Protocol protocol,
+    uint16_t key,
+    NetHandler* handler)
+{
+    if((nullptr == handler) || (Ethernet::Protocol::OTHER == protocol)) {
+        return false;
+    }
+
+    HandlerSlot& slot = _handlers[findSlot(protocol, key)];
+    if(nullptr == slot.handler) {
+        if(MAX_HANDLERS == _handlerCount) {
+            return false;
+        }
+        ++_handlerCount;
+        slot.protocol = protocol;
+        slot.key = key;
+    }
+    slot.handler = handler;
+    return true;
+}
+
+/**
+ * @brief Unregister handler of frames, the frames are not processed
+ * @param [in] protocol - protocol of frames
+ * @param [in] key - ICMP type, UDP or TCP port, zero for ARP
+ */
+void NetStack::removeHandler(Ethernet::Protocol protocol, uint16_t key)
+{
+    size_t free = findSlot(protocol, key);
+    if(nullptr == _handlers[free].handler) {
+        return;
+    }
+    _handlers[free].handler = nullptr;
+    --_handlerCount;
+
+    // the next slots of the same search are moved into free one,
+    // so the searches do not stop on it (linear probing)
+    for(size_t i = (free + 1) & (HANDLER_SLOTS - 1);
+        _handlers[i].handler != nullptr;
+        i = (i + 1) & (HANDLER_SLOTS - 1)) {
+        const size_t home = getHash(_handlers[i].protocol, _handlers[i].key);
+        const size_t toFree = (free - home) & (HANDLER_SLOTS - 1);
+        const size_t toSlot = (i - home) & (HANDLER_SLOTS - 1);
+        if(toFree < toSlot) {
+            _handlers[free] = _handlers[i];
+            _handlers[i].handler = nullptr;
+            free = i;
+        }
+    }
+}
+
+/**
+ * @brief Get registered handler of frames
+ * @param [in] protocol - protocol of frames
+ * @param [in] key - ICMP type, UDP or TCP port, zero for ARP
+ * @retval pointer on handler, nullptr - the frames are not processed
+ */
+NetHandler* NetStack::getHandler(Ethernet::Protocol protocol,
+    uint16_t key) const
+{
+    return _handlers[findSlot(protocol, key)].handler;
+}
+
+NetDevice* NetStack::getDevice() const
+{
+    return _device;
+}
+
+PacketPool* NetStack::getPool() const
+{
+    return _pool;
+}
+
+uint32_t NetStack::getIpAddr() const
+{
+    return _ipAddr;
+}
+
+uint16_t NetStack::getTcpPort() const
+{
+    return _tcpPort;
+}
+
+/**
+ * @brief Identifier of new IP packet (the replies keep the identifier
+ *        of request)
+ */
+uint16_t NetStack::getNextIpId()
+{
+    return _ipId++;
+}
+
+/**
+ * @brief First slot of search of handler
+ */
+size_t NetStack::getHash(Ethernet::Protocol protocol, uint16_t key)
+{
+    const size_t hash =
+        key ^ (key >> 8) ^ (static_cast<size_t>(protocol) << 2);
+    return hash & (HANDLER_SLOTS - 1);
+}
+
+/**
+ * @brief Find slot of handler
+ * @param [in] protocol - protocol of frames
+ * @param [in] key - ICMP type, UDP or TCP port, zero for ARP
+ * @retval index of slot of handler, or of free slot if it is not found
+ */
+size_t NetStack::findSlot(Ethernet::Protocol protocol, uint16_t key) const
+{
+    size_t i = getHash(protocol, key);
+    while((_handlers[i].handler != nullptr) &&
+          ((_handlers[i].protocol != protocol) || (_handlers[i].key != key))) {
+        i = (i + 1) & (HANDLER_SLOTS - 1);
+    }
+    return i;
+}
+
+/**
+ * @brief Process received packet
+ * @param [in] buffer - buffer of packet, at least its head is there
+ *        (the reply is built in place)
+ */
+void NetStack::handlePacket(PacketBuffer* buffer)
+{
+    static const Instrumentation::FrameType FRAME_TYPES[] = {
+        Instrumentation::FRAME_OTHER,
+        Instrumentation::FRAME_ARP,
+        Instrumentation::FRAME_ICMP,
+        Instrumentation::FRAME_UDP,
+        Instrumentation::FRAME_TCP
+    };
+
+    uint8_t* frame = buffer->payload();
+    const size_t pacLen = buffer->len;
+    Profiler& profiler = _device->getProfiler();
+    profiler.begin(Instrumentation::STAGE_CLASSIFY);
+
+    // the data of other packets is not read from device
+    Ethernet::FrameInfo info;
+    if(!Ethernet::ClassifyFrame(frame, pacLen, _ipAddr, &info)) {
+        profiler.end(Instrumentation::STAGE_CLASSIFY);
+        profiler.commit(Instrumentation::FRAME_OTHER, pacLen);
+        return;
+    }
+    if((info.protocol != Ethernet::Protocol::ARP) &&
+        !_device->isValidChecksum(
+            frame, Ethernet::IP_P, Ethernet::IpHeader::SIZE)) {
+        profiler.end(Instrumentation::STAGE_CLASSIFY);
+        profiler.commit(Instrumentation::FRAME_DROPPED, pacLen);
+        return;
+    }
+
+    NetHandler* handler = _handlers[findSlot(info.protocol, info.key)].handler;
+    profiler.end(Instrumentation::STAGE_CLASSIFY);
+    if(nullptr == handler) {
+        profiler.commit(Instrumentation::FRAME_OTHER, pacLen);
+        return;
+    }
+
+    if(!handler->handle(this, buffer, info)) {
+        profiler.commit(Instrumentation::FRAME_DROPPED, pacLen);
+        return;
+    }
+    profiler.commit(
+        FRAME_TYPES[static_cast<size_t>(info.protocol)], pacLen);
+}
+
+/**
+ * @brief Answer to ARP request, the reply is built in place
+ */
+bool ArpResponder::handle(NetStack* stack,
+    PacketBuffer* buffer,
+    const Ethernet::FrameInfo& info)
+{
+    NetDevice* device = stack->getDevice();
+    Profiler& profiler = device->getProfiler();
+    uint8_t* frame = buffer->payload();
+
+    profiler.begin(Instrumentation::STAGE_REPLY);
+    const size_t ansLel = Ethernet::MakeArpAnswerFromRequest(
+        frame, info.len, device->getMacAddr(), stack->getIpAddr());
+    profiler.end(Instrumentation::STAGE_REPLY);
+
+    profiler.begin(Instrumentation::STAGE_SEND);
+    device->send(frame, ansLel);
+    profiler.end(Instrumentation::STAGE_SEND);
+    return true;
+}
+
+/**
+ * @brief Answer to ICMP echo request, the echo data is not read out,
+ *        it is checked in place and copied into reply by device
+ */
+bool EchoResponder::handle(NetStack* stack,
+    PacketBuffer* buffer,
+    const Ethernet::FrameInfo& info)
+{
+    NetDevice* device = stack->getDevice();
+    Profiler& profiler = device->getProfiler();
+    uint8_t* frame = buffer->payload();
+
+    profiler.begin(Instrumentation::STAGE_CLASSIFY);
+    const bool isValid = device->isValidChecksum(frame,
+        Ethernet::TRANSPORT_P,
+        info.len - Ethernet::TRANSPORT_P);
+    profiler.end(Instrumentation::STAGE_CLASSIFY);
+    if(!isValid) {
+        return false;
+    }
+
+    profiler.begin(Instrumentation::STAGE_REPLY);
+    const size_t ansLel = Ethernet::MakeIcmpEchoAnswerFromRequest(
+        frame, info.len, device->getMacAddr(), stack->getIpAddr());
+    profiler.end(Instrumentation::STAGE_REPLY);
+
+    // only the headers are changed, the echo data is copied
+    // from received frame inside device, the checksums of head
+    // are updated for changed fields, they are sent as is
+    profiler.begin(Instrumentation::STAGE_SEND);
+    device->sendReply(frame,
+        Ethernet::TRANSPORT_P + Ethernet::IcmpHeader::SIZE,
+        ansLel,
+        0,
+        0);
+    profiler.end(Instrumentation::STAGE_SEND);
+    return true;
+}
@@ -0,0 +1,166 @@
+/**
+ ******************************************************************************
+ * @file    net_stack.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the protocol handling over network device:
+ *          classification of frames and dispatch to registered handlers.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NET_STACK_HPP
+#define __NET_STACK_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "net_device.hpp"
+#include "packet_pool.hpp"
+#include "ethernet.hpp"
+
+class NetStack;
+
+/**
+ * @brief Handler of received frames of one protocol and key (ICMP type,
+ *        UDP or TCP port), it is registered in NetStack
+ */
+class NetHandler {
+  public:
+    virtual ~NetHandler() = default;
+
+    /**
+     * @brief Process received frame, the reply is built in its buffer
+     * @param [in] stack - stack of frame, its device sends reply
+     * @param [in] buffer - buffer of frame, at least its head is there
+     * @param [in] info - classification of frame
+     * @retval true - frame is accepted, false - frame is dropped
+     */
+    virtual bool handle(NetStack* stack,
+        PacketBuffer* buffer,
+        const Ethernet::FrameInfo& info) = 0;
+};
+
+/**
+ * @brief Answer to ARP requests for my IP address
+ */
+class ArpResponder final : public NetHandler {
+  public:
+    bool handle(NetStack*, PacketBuffer*, const Ethernet::FrameInfo&) override;
+};
+
+/**
+ * @brief Answer to ICMP echo requests (ping)
+ */
+class EchoResponder final : public NetHandler {
+  public:
+    bool handle(NetStack*, PacketBuffer*, const Ethernet::FrameInfo&) override;
+};
+
+/**
+ * @brief Class of protocol stack. The frame is classified once, then
+ *        the handler of its protocol and key is found in hash table,
+ *        so the cost of dispatch does not grow with number of handlers.
+ */
+class NetStack final
+    : private NonCopyable<NetStack>
+    , private NonMovable<NetStack> {
+  public:
+    static constexpr size_t POLL_BUDGET = 4;
+
+    /// Maximum of registered handlers (with ARP and echo responders)
+    static constexpr size_t MAX_HANDLERS = 8;
+
+    /// Headroom of received frame: 14 bytes of ethernet header
+    /// and 2 bytes align IP header on 32-bit word
+    static constexpr size_t RX_HEADROOM = 2;
+
+    struct Config {
+        uint32_t ipAddr;    ///< See Ethernet::makeIpAddr
+        uint16_t tcpPort;    ///< Port of TCP server (see TcpEngine)
+        size_t pollBudget;    ///< Maximum frames processed by one poll()
+
+        Config() : ipAddr(0), tcpPort(0), pollBudget(POLL_BUDGET) {}
+    };
+
+    NetStack(NetDevice*, PacketPool*, const Config*);
+
+    size_t poll();
+
+    bool addHandler(Ethernet::Protocol, uint16_t, NetHandler*);
+
+    void removeHandler(Ethernet::Protocol, uint16_t);
+
+    NetHandler* getHandler(Ethernet::Protocol, uint16_t) const;
+
+    NetDevice* getDevice() const;
+
+    PacketPool* getPool() const;
+
+    uint32_t getIpAddr() const;
+
+    uint16_t getTcpPort() const;
+
+    uint16_t getNextIpId();
+
+  private:
+    enum Default {
+        IP_IDENTIFIER = 0x01,
+
+        /// Slots of hash table of handlers, power of two, at least half
+        /// is free, so a search ends on near free slot
+        HANDLER_SLOTS = 2 * MAX_HANDLERS
+    };
+
+    static_assert(!(HANDLER_SLOTS & (HANDLER_SLOTS - 1)),
+        "Slots of handlers must be power of two");
+
+    /// Slot of hash table, free if handler is nullptr
+    struct HandlerSlot {
+        NetHandler* handler;
+        uint16_t key;
+        Ethernet::Protocol protocol;
+    };
+
+    NetStack() = delete;
+
+    void handlePacket(PacketBuffer*);
+
+    static size_t getHash(Ethernet::Protocol, uint16_t);
+
+    size_t findSlot(Ethernet::Protocol, uint16_t) const;
+
+    NetDevice* const _device;
+
+    PacketPool* const _pool;    ///< Frame buffers
+
+    const uint16_t _tcpPort;
+
+    const uint32_t _ipAddr;
+
+    uint16_t _ipId;    ///< Identifier of next sent IP packet
+
+    const size_t _pollBudget;
+
+    HandlerSlot _handlers[HANDLER_SLOTS];
+
+    size_t _handlerCount;
+
+    ArpResponder _arpResponder;
+
+    EchoResponder _echoResponder;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ ******************************************************************************
+ * @file    packet_pool.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the pool of frame buffers with headroom
+ *          for prepended headers.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "packet_pool.hpp"
+
+/**
+ * @brief Constructor
+ * @param [in] buffers - array of buffers
+ * @param [in] free - array of pointers on free buffers, the same size
+ * @param [in] capacity - number of buffers
+ */
+PacketPool::PacketPool(PacketBuffer* buffers,
+    PacketBuffer** free,
+    size_t capacity) :
+    _buffers(buffers),
+    _free(free),
+    _capacity(capacity),
+    _freeCount(capacity)
+{
+    for(size_t i = 0; i < _capacity; ++i) {
+        _buffers[i].refCount = 0;
+        _free[i] = &_buffers[i];
+    }
+    resetStatistics();
+}
+
+/**
+ * @brief Get free buffer, its packet is empty
+ * @param [in] headroom - room before packet for headers
+ * @retval pointer on buffer (one owner), nullptr if pool is empty
+ */
+PacketBuffer* PacketPool::allocate(size_t headroom)
+{
+    if((0 == _freeCount) || (headroom > PacketBuffer::SIZE)) {
+        ++_statistics.failures;
+        return nullptr;
+    }
+
+    PacketBuffer* buffer = _free[--_freeCount];
+    buffer->offset = headroom;
+    buffer->len = 0;
+    buffer->refCount = 1;
+
+    ++_statistics.allocations;
+    ++_statistics.used;
+    if(_statistics.used > _statistics.highWater) {
+        _statistics.highWater = _statistics.used;
+    }
+    return buffer;
+}
+
+/**
+ * @brief Return buffer into pool
+ * @param [in] buffer - pointer on buffer, nullptr and free buffer (second
+ *        release) are ignored
+ */
+void PacketPool::release(PacketBuffer* buffer)
+{
+    if((nullptr == buffer) || (0 == buffer->refCount)) {
+        return;
+    }
+    if(0 == --buffer->refCount) {
+        _free[_freeCount++] = buffer;
+        --_statistics.used;
+    }
+}
+
+const PacketPool::Statistics& PacketPool::getStatistics() const
+{
+    return _statistics;
+}
+
+/**
+ * @brief Reset counters, the occupancy is kept
+ */
+void PacketPool::resetStatistics()
+{
+    _statistics.capacity = _capacity;
+    _statistics.used = _capacity - _freeCount;
+    _statistics.highWater = _statistics.used;
+    _statistics.allocations = 0;
+    _statistics.failures = 0;
+}
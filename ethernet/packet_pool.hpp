@@ -0,0 +1,161 @@
+/**
+ ******************************************************************************
+ * @file    packet_pool.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the pool of frame buffers with headroom
+ *          for prepended headers.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PACKET_POOL_HPP
+#define __PACKET_POOL_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+/**
+ * @brief Frame buffer of pool. The packet is stored from offset, the bytes
+ *        before it are headroom for headers of lower layers.
+ */
+struct PacketBuffer {
+    /// Size of buffer: maximum ethernet frame with CRC and headroom
+    static constexpr size_t SIZE = 1536;
+
+    alignas(uint32_t) uint8_t data[SIZE];
+
+    uint16_t offset;    ///< Start of packet in data
+
+    uint16_t len;    ///< Length of packet
+
+    uint8_t refCount;    ///< Owners of buffer, zero - buffer is free
+
+    uint8_t* payload()
+    {
+        return &data[offset];
+    }
+
+    size_t headroom() const
+    {
+        return offset;
+    }
+
+    size_t tailroom() const
+    {
+        return SIZE - offset - len;
+    }
+
+    /**
+     * @brief Add header before packet (into headroom)
+     * @param [in] size - length of header
+     * @retval pointer on header, nullptr if headroom is too small
+     */
+    uint8_t* prepend(size_t size)
+    {
+        if(size > offset) {
+            return nullptr;
+        }
+        offset -= size;
+        len += size;
+        return &data[offset];
+    }
+
+    /**
+     * @brief Remove header of packet
+     * @param [in] size - length of header
+     * @retval pointer on rest of packet, nullptr if packet is shorter
+     */
+    uint8_t* strip(size_t size)
+    {
+        if(size > len) {
+            return nullptr;
+        }
+        offset += size;
+        len -= size;
+        return &data[offset];
+    }
+};
+
+/**
+ * @brief Class of pool of frame buffers. The buffers are placed by derived
+ *        class (see StaticPacketPool), the users of pool do not depend on
+ *        their number. The pool is used from main loop only (not from
+ *        interrupt).
+ */
+class PacketPool
+    : private NonCopyable<PacketPool>
+    , private NonMovable<PacketPool> {
+  public:
+    /// Default number of buffers: received frame, reply and queued frames
+    static constexpr size_t BUFFER_COUNT = 4;
+
+    /// Default headroom of allocated buffer (room for ethernet, IP and UDP)
+    static constexpr size_t HEADROOM = 42;
+
+    /// Occupancy of pool
+    struct Statistics {
+        size_t capacity;    ///< Number of buffers
+        size_t used;    ///< Allocated buffers
+        size_t highWater;    ///< Maximum of allocated buffers
+        uint32_t allocations;
+        uint32_t failures;    ///< Allocations on empty pool
+    };
+
+    PacketBuffer* allocate(size_t = HEADROOM);
+
+    void release(PacketBuffer*);
+
+    const Statistics& getStatistics() const;
+
+    void resetStatistics();
+
+  protected:
+    PacketPool(PacketBuffer*, PacketBuffer**, size_t);
+
+  private:
+    PacketPool() = delete;
+
+    PacketBuffer* const _buffers;
+
+    PacketBuffer** const _free;    ///< Stack of free buffers
+
+    const size_t _capacity;
+
+    size_t _freeCount;
+
+    Statistics _statistics;
+};
+
+/**
+ * @brief Class of pool with statically placed buffers
+ * @tparam BUFFERS - number of buffers
+ */
+template<size_t BUFFERS = PacketPool::BUFFER_COUNT>
+class StaticPacketPool final : public PacketPool {
+  public:
+    static_assert(BUFFERS > 0, "Pool must have buffers");
+
+    StaticPacketPool() : PacketPool(_buffers, _free, BUFFERS) {}
+
+  private:
+    // the buffers are not constructed (trivial type), the base class
+    // fills them before members of this class are initialized
+    PacketBuffer _buffers[BUFFERS];
+
+    PacketBuffer* _free[BUFFERS];
+};
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ ******************************************************************************
+ * @file    spi_dma.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides all the SPI DMA firmware method.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "spi_dma.hpp"
+
+/**
+ * @brief Get instance of SPI DMA
+ * @param [in] spi - SPI1 (DMA1 channels 2/3) or SPI2 (DMA1 channels 4/5)
+ * @retval pointer on instance, nullptr if SPI has not DMA channels
+ */
+SpiDma* SpiDma::getInstance(SPI_TypeDef* spi)
+{
+    if(spi == SPI1) {
+        static SpiDma spi1Dma(
+            SPI1, DMA1_Channel2, DMA1_Channel3, 2, DMA1_Channel2_IRQn);
+        return &spi1Dma;
+    }
+    if(spi == SPI2) {
+        static SpiDma spi2Dma(
+            SPI2, DMA1_Channel4, DMA1_Channel5, 4, DMA1_Channel4_IRQn);
+        return &spi2Dma;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Constructor
+ * @param [in] spi - SPI port
+ * @param [in] rxChannel - DMA channel of SPI receive
+ * @param [in] txChannel - DMA channel of SPI transmit
+ * @param [in] rxChannelNumber - number of receive channel (for flags)
+ * @param [in] irq - interrupt of receive channel
+ */
+SpiDma::SpiDma(SPI_TypeDef* spi,
+    DMA_Channel_TypeDef* rxChannel,
+    DMA_Channel_TypeDef* txChannel,
+    uint8_t rxChannelNumber,
+    IRQn_Type irq) :
+    _spi(spi),
+    _rxChannel(rxChannel),
+    _txChannel(txChannel),
+    _rxChannelNumber(rxChannelNumber),
+    _isBusy(false),
+    _dummy(DUMMY_BYTE)
+{
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+    _rxChannel->CCR = 0;
+    _txChannel->CCR = 0;
+    _rxChannel->CPAR = reinterpret_cast<uint32_t>(&_spi->DR);
+    _txChannel->CPAR = reinterpret_cast<uint32_t>(&_spi->DR);
+
+    // Receive channel finishes last, it must preempt the EXTI of ENC28J60
+    NVIC_SetPriority(irq, 0);
+    NVIC_EnableIRQ(irq);
+}
+
+void SpiDma::startTransfer(const uint8_t* txData, uint8_t* rxData, size_t len)
+{
+    if(0 == len) {
+        return;
+    }
+    _isBusy = true;
+
+    // Receive: SPI -> memory, the receive byte is dropped into dummy
+    _rxChannel->CMAR = (rxData != nullptr) ?
+        reinterpret_cast<uint32_t>(rxData) :
+        reinterpret_cast<uint32_t>(&_dummy);
+    _rxChannel->CNDTR = len;
+    _rxChannel->CCR = DMA_CCR1_TCIE | DMA_CCR1_PL_1 |
+                      ((rxData != nullptr) ? DMA_CCR1_MINC : 0);
+
+    // Transmit: memory -> SPI, the dummy byte is repeated for read burst
+    _dummy = DUMMY_BYTE;
+    _txChannel->CMAR = (txData != nullptr) ?
+        reinterpret_cast<uint32_t>(txData) :
+        reinterpret_cast<uint32_t>(&_dummy);
+    _txChannel->CNDTR = len;
+    _txChannel->CCR =
+        DMA_CCR1_DIR | ((txData != nullptr) ? DMA_CCR1_MINC : 0);
+
+    _spi->CR2 |= SPI_CR2_RXDMAEN;
+    _rxChannel->CCR |= DMA_CCR1_EN;
+    _txChannel->CCR |= DMA_CCR1_EN;
+    _spi->CR2 |= SPI_CR2_TXDMAEN;
+}
+
+bool SpiDma::isBusy() const
+{
+    return _isBusy;
+}
+
+/**
+ * @brief Interrupt of complete receive channel
+ */
+void SpiDma::irqHandler()
+{
+    DMA1->IFCR = DMA_IFCR_CGIF1 << ((_rxChannelNumber - 1) * 4);
+
+    _rxChannel->CCR &= ~DMA_CCR1_EN;
+    _txChannel->CCR &= ~DMA_CCR1_EN;
+    _spi->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+
+    _isBusy = false;
+    complete();
+}
+
+extern "C" {
+void DMA1_Channel2_IRQHandler()
+{
+    SpiDma::getInstance(SPI1)->irqHandler();
+}
+
+void DMA1_Channel4_IRQHandler()
+{
+    SpiDma::getInstance(SPI2)->irqHandler();
+}
+}
@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ * @file    spi_dma.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides all the SPI DMA firmware method.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPI_DMA_HPP
+#define __SPI_DMA_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f10x.h"
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "dma_interface.hpp"
+
+/**
+ * @brief Class SPI DMA (DMA1 channels of SPI1 and SPI2)
+ */
+class SpiDma final
+    : private NonCopyable<SpiDma>
+    , private NonMovable<SpiDma>
+    , public DmaInterface {
+  public:
+    static SpiDma* getInstance(SPI_TypeDef*);
+
+    void startTransfer(const uint8_t*, uint8_t*, size_t) override;
+
+    bool isBusy() const override;
+
+    void irqHandler();
+
+  private:
+    /// Value transmitted when no data for transmit
+    static constexpr uint8_t DUMMY_BYTE = 0xFF;
+
+    SpiDma(SPI_TypeDef*,
+        DMA_Channel_TypeDef*,
+        DMA_Channel_TypeDef*,
+        uint8_t,
+        IRQn_Type);
+
+    SPI_TypeDef* const _spi;
+
+    DMA_Channel_TypeDef* const _rxChannel;
+
+    DMA_Channel_TypeDef* const _txChannel;
+
+    const uint8_t _rxChannelNumber;
+
+    volatile bool _isBusy;
+
+    uint8_t _dummy;
+};
+
+#endif
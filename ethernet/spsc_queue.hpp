@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ * @file    spsc_queue.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides lock-free single-producer/single-consumer
+ *          queue (producer is interrupt, consumer is main loop).
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPSC_QUEUE_HPP
+#define __SPSC_QUEUE_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+
+/**
+ * @brief Class of lock-free ring.
+ *        Only producer writes head, only consumer writes tail.
+ * @tparam T - type of element
+ * @tparam SIZE - capacity of ring plus one, power of two
+ */
+template<typename T, size_t SIZE>
+class SpscQueue {
+    static_assert((SIZE >= 2) && (0 == (SIZE & (SIZE - 1))),
+        "Size of queue must be power of two");
+
+  public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    /**
+     * @brief Put element (producer side)
+     * @param [in] value - element
+     * @retval false if queue is full
+     */
+    bool push(const T& value)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        const size_t next = (head + 1) & (SIZE - 1);
+        if(next == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        _buffer[head] = value;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Get element (consumer side)
+     * @param [out] value - element
+     * @retval false if queue is empty
+     */
+    bool pop(T& value)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = _buffer[tail];
+        _tail.store((tail + 1) & (SIZE - 1), std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return _tail.load(std::memory_order_acquire) ==
+               _head.load(std::memory_order_acquire);
+    }
+
+  private:
+    T _buffer[SIZE];
+
+    std::atomic<size_t> _head;
+
+    std::atomic<size_t> _tail;
+};
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ ******************************************************************************
+ * @file    static_net.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the statically placed network interface:
+ *          ENC28J60 driver, frame buffers and protocol stack without heap.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STATIC_NET_HPP
+#define __STATIC_NET_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "enc28j60.hpp"
+#include "packet_pool.hpp"
+#include "net_stack.hpp"
+#include "net_config.hpp"
+
+/**
+ * @brief Class of network interface configured by NetConfig. The object
+ *        is placed statically (global or function static), its members
+ *        are constructed in order: driver, pool, stack.
+ */
+template<class CONFIG>
+class StaticNet final
+    : private NonCopyable<StaticNet<CONFIG>>
+    , private NonMovable<StaticNet<CONFIG>> {
+  public:
+    /**
+     * @brief Constructor
+     * @param [in] interface - SPI interface of ENC28J60
+     * @param [in] dma - channel of bursts, nullptr - polled mode
+     * @param [in] idle - function called while burst of DMA runs,
+     *        nullptr - the driver waits for end of burst
+     * @param [in] idleContext - argument of idle function
+     */
+    StaticNet(const SpiInterface::Config* interface,
+        DmaInterface* dma,
+        DmaInterface::Callback idle = nullptr,
+        void* idleContext = nullptr) :
+        _net(interface, getDeviceConfig(dma, idle, idleContext)),
+        _stack(&_net, &_pool, getStackConfig())
+    {
+    }
+
+    Enc28j60& getDevice()
+    {
+        return _net;
+    }
+
+    NetStack& getStack()
+    {
+        return _stack;
+    }
+
+    PacketPool& getPool()
+    {
+        return _pool;
+    }
+
+    size_t poll()
+    {
+        return _stack.poll();
+    }
+
+  private:
+    StaticNet() = delete;
+
+    static const Enc28j60::Config* getDeviceConfig(DmaInterface* dma,
+        DmaInterface::Callback idle,
+        void* idleContext)
+    {
+        static Enc28j60::Config config;
+        for(size_t i = 0; i < NetDevice::MAC_ADDR_SIZE; ++i) {
+            config.macAddr[i] = CONFIG::getMacByte(i);
+        }
+        config.dma = dma;
+        config.idle = idle;
+        config.idleContext = idleContext;
+        config.txSlots = CONFIG::txSlots;
+        config.txSlotSize = CONFIG::txSlotSize;
+        return &config;
+    }
+
+    static const NetStack::Config* getStackConfig()
+    {
+        static NetStack::Config config;
+        config.ipAddr = CONFIG::ipAddr;
+        config.tcpPort = CONFIG::tcpPort;
+        config.pollBudget = CONFIG::pollBudget;
+        return &config;
+    }
+
+    Enc28j60 _net;
+
+    StaticPacketPool<CONFIG::bufferCount> _pool;    ///< Frame buffers
+
+    NetStack _stack;
+};
+
+#endif
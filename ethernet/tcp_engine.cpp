@@ -0,0 +1,934 @@
+/**
+ ******************************************************************************
+ * @file    tcp_engine.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the TCP server over protocol stack:
+ *          static table of connections, handshake, in-order receive
+ *          and retransmit queue of sent segments.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "tcp_engine.hpp"
+
+using Ethernet::TcpHeader;
+
+/**
+ * @brief Constructor
+ * @param [in] stack - protocol stack, its Config::tcpPort is listened
+ * @param [in] application - application of connections
+ */
+TcpEngine::TcpEngine(NetStack* stack, TcpApplication* application) :
+    _stack(stack),
+    _application(application),
+    _port(0),
+    _now(0),
+    _secret(mix(CycleCounter::now()))
+{
+    for(size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+        _connections[i]._state = TcpConnection::State::CLOSED;
+        _connections[i]._index = i;
+    }
+    for(size_t i = 0; i < RETRANSMIT_SLOTS; ++i) {
+        _segments[i].buffer = nullptr;
+    }
+    resetStatistics();
+}
+
+TcpEngine::~TcpEngine()
+{
+    stop();
+}
+
+/**
+ * @brief Start server on TCP port of stack
+ * @retval true - port is registered, false - port is zero or table
+ *         of handlers is full
+ */
+bool TcpEngine::listen()
+{
+    stop();
+    const uint16_t port = _stack->getTcpPort();
+    if((0 == port) ||
+        !_stack->addHandler(Ethernet::Protocol::TCP, port, this)) {
+        return false;
+    }
+    _port = port;
+    return true;
+}
+
+/**
+ * @brief Stop server, the open connections are reset
+ */
+void TcpEngine::stop()
+{
+    if(0 == _port) {
+        return;
+    }
+    for(size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+        if(_connections[i]._state != TcpConnection::State::CLOSED) {
+            abort(&_connections[i]);
+        }
+    }
+    _stack->removeHandler(Ethernet::Protocol::TCP, _port);
+    _port = 0;
+}
+
+/**
+ * @brief Get buffer for data of segment, the data is written from
+ *        payload() and its length is set in len
+ * @retval pointer on buffer with headroom for headers, nullptr if pool
+ *         is empty
+ */
+PacketBuffer* TcpEngine::allocate()
+{
+    return _stack->getPool()->allocate(HEADERS_SIZE);
+}
+
+/**
+ * @brief Send data of buffer as one segment, the headers are built
+ *        in headroom of buffer. The buffer is kept in retransmit queue
+ *        until the data is acknowledged, then it is released.
+ * @param [in] connection - established connection
+ * @param [in] buffer - buffer of data (see allocate())
+ * @retval true - segment is sent, false - the data does not fit send space
+ *         (see getSendSpace()), the buffer stays with caller
+ */
+bool TcpEngine::sendBuffer(TcpConnection* connection, PacketBuffer* buffer)
+{
+    return sendBuffer(connection,
+        buffer,
+        Ethernet::SumWords(buffer->payload(), buffer->len));
+}
+
+/**
+ * @brief Send data of buffer as one segment, the sum of data is known
+ *        (e.g. precomputed for constant data), so the data is not summed
+ * @param [in] connection - established connection
+ * @param [in] buffer - buffer of data (see allocate())
+ * @param [in] dataSum - sum of data (see Ethernet::SumWords)
+ * @retval true - segment is sent, false - the buffer stays with caller
+ */
+bool TcpEngine::sendBuffer(TcpConnection* connection,
+    PacketBuffer* buffer,
+    uint16_t dataSum)
+{
+    if((buffer->headroom() < HEADERS_SIZE) ||
+        (buffer->len > getSendSpace(connection))) {
+        return false;
+    }
+    Segment* segment = nullptr;
+    for(size_t i = 0; i < RETRANSMIT_SLOTS; ++i) {
+        if(nullptr == _segments[i].buffer) {
+            segment = &_segments[i];
+            break;
+        }
+    }
+    if(nullptr == segment) {
+        return false;
+    }
+
+    const size_t dataLen = buffer->len;
+    uint8_t* frame = buffer->prepend(HEADERS_SIZE);
+    buildSegment(frame,
+        connection,
+        connection->_sendNext,
+        TcpHeader::FLAG_ACK | TcpHeader::FLAG_PUSH,
+        dataLen,
+        dataSum);
+    connection->_sendNext += dataLen;
+
+    segment->connection = connection;
+    segment->buffer = buffer;
+    segment->sequenceEnd = connection->_sendNext;
+    segment->deadline = _now + RTO_MS;
+    segment->retries = 0;
+
+    _stack->getDevice()->send(frame, buffer->len);
+    return true;
+}
+
+/**
+ * @brief Send data, it is copied into buffers of pool
+ * @param [in] connection - established connection
+ * @param [in] data - pointer on data
+ * @param [in] len - length of data
+ * @retval length of sent data, the rest is sent after onSent()
+ */
+size_t TcpEngine::send(TcpConnection* connection,
+    const uint8_t* data,
+    size_t len)
+{
+    size_t sent = 0;
+    while(sent < len) {
+        size_t size = getSendSpace(connection);
+        if(0 == size) {
+            break;
+        }
+        PacketBuffer* buffer = allocate();
+        if(nullptr == buffer) {
+            break;
+        }
+        if(size > (len - sent)) {
+            size = len - sent;
+        }
+        memcpy(buffer->payload(), &data[sent], size);
+        buffer->len = size;
+        if(!sendBuffer(connection, buffer)) {
+            _stack->getPool()->release(buffer);
+            break;
+        }
+        sent += size;
+    }
+    return sent;
+}
+
+/**
+ * @brief Get maximum data of next segment
+ * @param [in] connection - connection
+ * @retval length of data: limited by MSS and window of peer, zero if
+ *         connection does not send or retransmit queue is full
+ */
+size_t TcpEngine::getSendSpace(const TcpConnection* connection) const
+{
+    if((connection->_state != TcpConnection::State::ESTABLISHED) &&
+        (connection->_state != TcpConnection::State::CLOSE_WAIT)) {
+        return 0;
+    }
+    bool isSlotFree = false;
+    for(size_t i = 0; i < RETRANSMIT_SLOTS; ++i) {
+        if(nullptr == _segments[i].buffer) {
+            isSlotFree = true;
+            break;
+        }
+    }
+    const uint32_t inFlight = connection->_sendNext - connection->_sendUnacked;
+    if(!isSlotFree || (inFlight >= connection->_sendWindow)) {
+        return 0;
+    }
+    const size_t space = connection->_sendWindow - inFlight;
+    return (space < connection->_mss) ? space : connection->_mss;
+}
+
+/**
+ * @brief Close connection: FIN is sent after queued data
+ * @param [in] connection - connection
+ */
+void TcpEngine::close(TcpConnection* connection)
+{
+    switch(connection->_state) {
+        case TcpConnection::State::SYN_RECEIVED:
+            abort(connection);
+            return;
+
+        case TcpConnection::State::ESTABLISHED:
+            connection->_state = TcpConnection::State::FIN_WAIT_1;
+            break;
+
+        case TcpConnection::State::CLOSE_WAIT:
+            connection->_state = TcpConnection::State::LAST_ACK;
+            break;
+
+        default:
+            return;
+    }
+    // FIN takes one sequence number
+    connection->_sendNext += 1;
+    connection->_retries = 0;
+    connection->_deadline = _now + RTO_MS;
+    sendControl(connection, TcpHeader::FLAG_FIN | TcpHeader::FLAG_ACK);
+}
+
+/**
+ * @brief Reset connection, its queued segments are dropped
+ * @param [in] connection - connection
+ */
+void TcpEngine::abort(TcpConnection* connection)
+{
+    if(TcpConnection::State::CLOSED == connection->_state) {
+        return;
+    }
+    sendControl(connection, TcpHeader::FLAG_RST | TcpHeader::FLAG_ACK);
+    ++_statistics.resets;
+    release(connection, false);
+}
+
+/**
+ * @brief Process timers: retransmit of segments, SYN and FIN, probe
+ *        of zero window, release of closed connections. Must be called
+ *        periodically (every RTO_MS or more often).
+ * @param [in] now - time in milliseconds, it may wrap around
+ */
+void TcpEngine::tick(uint32_t now)
+{
+    _now = now;
+    NetDevice* device = _stack->getDevice();
+
+    for(size_t i = 0; i < RETRANSMIT_SLOTS; ++i) {
+        Segment& segment = _segments[i];
+        if((nullptr == segment.buffer) || isBefore(now, segment.deadline)) {
+            continue;
+        }
+        TcpConnection* connection = segment.connection;
+        if(segment.retries >= MAX_RETRIES) {
+            ++_statistics.timeouts;
+            sendControl(connection, TcpHeader::FLAG_RST | TcpHeader::FLAG_ACK);
+            release(connection, true);
+            continue;
+        }
+        ++segment.retries;
+        segment.deadline = now + (RTO_MS << segment.retries);
+
+        // the acknowledge is updated, the data is not changed
+        uint8_t* frame = segment.buffer->payload();
+        TcpHeader tcp(&frame[Ethernet::TRANSPORT_P]);
+        Ethernet::RewriteWord32(&tcp.data()[TcpHeader::CHECKSUM],
+            &tcp.data()[TcpHeader::ACKNOWLEDGE],
+            connection->_receiveNext);
+        connection->_isAckPending = false;
+
+        ++_statistics.retransmits;
+        device->send(frame, segment.buffer->len);
+    }
+
+    for(size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+        TcpConnection* connection = &_connections[i];
+        if((TcpConnection::State::CLOSED == connection->_state) ||
+            isBefore(now, connection->_deadline)) {
+            continue;
+        }
+        switch(connection->_state) {
+            case TcpConnection::State::SYN_RECEIVED:
+            case TcpConnection::State::FIN_WAIT_1:
+            case TcpConnection::State::CLOSING:
+            case TcpConnection::State::LAST_ACK:
+                if(connection->_retries >= MAX_RETRIES) {
+                    ++_statistics.timeouts;
+                    release(connection, false);
+                    break;
+                }
+                ++connection->_retries;
+                connection->_deadline = now + (RTO_MS << connection->_retries);
+                ++_statistics.retransmits;
+                sendControl(connection,
+                    (TcpConnection::State::SYN_RECEIVED == connection->_state) ?
+                        (TcpHeader::FLAG_SYN | TcpHeader::FLAG_ACK) :
+                        (TcpHeader::FLAG_FIN | TcpHeader::FLAG_ACK));
+                break;
+
+            case TcpConnection::State::ESTABLISHED:
+            case TcpConnection::State::CLOSE_WAIT:
+                // the update of zero window may be lost, so it is requested
+                // while nothing is in flight (RFC 1122, 4.2.2.17)
+                if((0 == connection->_sendWindow) &&
+                    (connection->_sendNext == connection->_sendUnacked)) {
+                    if(connection->_retries < MAX_RETRIES) {
+                        ++connection->_retries;
+                    }
+                    connection->_deadline =
+                        now + (RTO_MS << connection->_retries);
+                    ++_statistics.probes;
+                    sendProbe(connection);
+                }
+                break;
+
+            case TcpConnection::State::FIN_WAIT_2:
+            case TcpConnection::State::TIME_WAIT:
+                release(connection, false);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Process received segment of listened port: the rest of frame is
+ *        read from device, then the segment is passed to its connection
+ */
+bool TcpEngine::handle(NetStack* stack,
+    PacketBuffer* buffer,
+    const Ethernet::FrameInfo& info)
+{
+    NetDevice* device = stack->getDevice();
+    Profiler& profiler = device->getProfiler();
+    uint8_t* frame = buffer->payload();
+
+    profiler.begin(Instrumentation::STAGE_RECEIVE);
+    device->fetch(frame);
+    profiler.end(Instrumentation::STAGE_RECEIVE);
+
+    const TcpHeader tcp(&frame[Ethernet::TRANSPORT_P]);
+    const size_t tcpLen = info.len - Ethernet::TRANSPORT_P;
+    const size_t headerLen = tcp.getHeaderLen();
+    if((headerLen < TcpHeader::SIZE) || (headerLen > tcpLen)) {
+        ++_statistics.errors;
+        return false;
+    }
+    profiler.begin(Instrumentation::STAGE_CLASSIFY);
+    const bool isValid = (0 == Ethernet::CalcTransportChecksum(frame,
+                                   tcpLen,
+                                   Ethernet::PacketType_t::TCP));
+    profiler.end(Instrumentation::STAGE_CLASSIFY);
+    if(!isValid) {
+        ++_statistics.errors;
+        return false;
+    }
+
+    profiler.begin(Instrumentation::STAGE_REPLY);
+    const uint8_t flags = tcp.getFlags();
+    const uint32_t sequence = tcp.getSequence();
+    const size_t dataLen = tcpLen - headerLen;
+    TcpConnection* connection = findConnection(
+        Ethernet::IpHeader(&frame[Ethernet::IP_P]).getSrcIp(),
+        tcp.getSrcPort());
+
+    const uint8_t handshake =
+        TcpHeader::FLAG_SYN | TcpHeader::FLAG_ACK | TcpHeader::FLAG_RST;
+    // new SYN of the same ports ends TIME_WAIT (RFC 1122, 4.2.2.13),
+    // the peer reuses its ports sooner than our TIME_WAIT ends
+    if((connection != nullptr) &&
+        (TcpConnection::State::TIME_WAIT == connection->_state) &&
+        (TcpHeader::FLAG_SYN == (flags & handshake))) {
+        release(connection, false);
+        connection = nullptr;
+    }
+
+    if(nullptr == connection) {
+        if(TcpHeader::FLAG_SYN != (flags & handshake)) {
+            sendReset(frame, tcpLen);
+        }
+        else if(nullptr == (connection = openConnection(frame))) {
+            // SYN is dropped without reset, the peer repeats it later
+            ++_statistics.refused;
+        }
+        else {
+            sendControl(connection, TcpHeader::FLAG_SYN | TcpHeader::FLAG_ACK);
+        }
+        profiler.end(Instrumentation::STAGE_REPLY);
+        return true;
+    }
+
+    if(flags & TcpHeader::FLAG_RST) {
+        // the reset must be in window, else it may be forged
+        if(sequence == connection->_receiveNext) {
+            ++_statistics.resets;
+            release(connection,
+                connection->_state != TcpConnection::State::SYN_RECEIVED);
+        }
+    }
+    else if(flags & TcpHeader::FLAG_SYN) {
+        // repeated SYN: SYN-ACK is lost, else the acknowledge is sent
+        const bool isRepeated =
+            (TcpConnection::State::SYN_RECEIVED == connection->_state) &&
+            ((sequence + 1) == connection->_receiveNext);
+        sendControl(connection,
+            isRepeated ? (TcpHeader::FLAG_SYN | TcpHeader::FLAG_ACK) :
+                         TcpHeader::FLAG_ACK);
+    }
+    else if(flags & TcpHeader::FLAG_ACK) {
+        const bool isSent =
+            acknowledge(connection, tcp.getAcknowledge(), tcp.getWindow());
+        const bool isAllAcked =
+            (connection->_sendUnacked == connection->_sendNext);
+
+        switch(connection->_state) {
+            case TcpConnection::State::SYN_RECEIVED:
+                if(isAllAcked) {
+                    connection->_state = TcpConnection::State::ESTABLISHED;
+                    ++_statistics.accepted;
+                    _application->onConnect(this, connection);
+                }
+                break;
+
+            case TcpConnection::State::FIN_WAIT_1:
+                if(isAllAcked) {
+                    connection->_state = TcpConnection::State::FIN_WAIT_2;
+                    connection->_deadline = _now + FIN_WAIT_MS;
+                }
+                break;
+
+            case TcpConnection::State::CLOSING:
+                if(isAllAcked) {
+                    connection->_state = TcpConnection::State::TIME_WAIT;
+                    connection->_deadline = _now + TIME_WAIT_MS;
+                }
+                break;
+
+            case TcpConnection::State::LAST_ACK:
+                if(isAllAcked) {
+                    release(connection, false);
+                }
+                break;
+
+            default:
+                break;
+        }
+        if(isSent) {
+            notifySent(connection);
+        }
+
+        // the data and FIN are accepted in order only
+        if((connection->_state != TcpConnection::State::CLOSED) &&
+            ((dataLen > 0) || (flags & TcpHeader::FLAG_FIN))) {
+            if(sequence != connection->_receiveNext) {
+                ++_statistics.outOfOrder;
+                connection->_isAckPending = true;
+            }
+            else {
+                const bool isReceiving =
+                    (TcpConnection::State::ESTABLISHED == connection->_state) ||
+                    (TcpConnection::State::FIN_WAIT_1 == connection->_state) ||
+                    (TcpConnection::State::FIN_WAIT_2 == connection->_state);
+                if(isReceiving && (dataLen > 0)) {
+                    connection->_receiveNext += dataLen;
+                    connection->_isAckPending = true;
+                    _application->onReceive(
+                        this, connection, &tcp.data()[headerLen], dataLen);
+                }
+                if((flags & TcpHeader::FLAG_FIN) &&
+                    (connection->_state != TcpConnection::State::CLOSED)) {
+                    receiveFin(connection);
+                }
+            }
+        }
+        // the acknowledge is not sent if a reply has carried it
+        if((connection->_state != TcpConnection::State::CLOSED) &&
+            connection->_isAckPending) {
+            sendControl(connection, TcpHeader::FLAG_ACK);
+        }
+    }
+    profiler.end(Instrumentation::STAGE_REPLY);
+    return true;
+}
+
+NetStack* TcpEngine::getStack() const
+{
+    return _stack;
+}
+
+size_t TcpEngine::getConnectionCount() const
+{
+    size_t count = 0;
+    for(size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+        if(_connections[i]._state != TcpConnection::State::CLOSED) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+const TcpEngine::Statistics& TcpEngine::getStatistics() const
+{
+    return _statistics;
+}
+
+void TcpEngine::resetStatistics()
+{
+    memset(&_statistics, 0, sizeof(_statistics));
+}
+
+/**
+ * @brief Compare sequence numbers modulo 2^32
+ * @retval true - first is before second
+ */
+bool TcpEngine::isBefore(uint32_t first, uint32_t second)
+{
+    return static_cast<int32_t>(first - second) < 0;
+}
+
+/**
+ * @brief Get MSS option of SYN segment
+ * @param [in] tcp - header of segment
+ * @retval MSS of peer, DEFAULT_MSS if option is absent
+ */
+uint16_t TcpEngine::parseMss(const TcpHeader& tcp)
+{
+    const uint8_t* option = &tcp.data()[TcpHeader::OPTIONS];
+    const uint8_t* const end = &tcp.data()[tcp.getHeaderLen()];
+    while(option < end) {
+        if(OPTION_END == option[0]) {
+            break;
+        }
+        if(OPTION_NOP == option[0]) {
+            ++option;
+            continue;
+        }
+        if(((option + 1) >= end) || (option[1] < 2) ||
+            ((option + option[1]) > end)) {
+            break;
+        }
+        if((OPTION_MSS == option[0]) && (OPTION_MSS_SIZE == option[1])) {
+            return Ethernet::getWord16(&option[2]);
+        }
+        option += option[1];
+    }
+    return DEFAULT_MSS;
+}
+
+/**
+ * @brief Hash of 32-bit value, each bit of value changes half of bits
+ *        of hash (finalizer of MurmurHash3)
+ */
+uint32_t TcpEngine::mix(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x85EBCA6B;
+    value ^= value >> 13;
+    value *= 0xC2B2AE35;
+    value ^= value >> 16;
+    return value;
+}
+
+/**
+ * @brief Initial sequence of connection (RFC 6528): clock of 4 us plus
+ *        hash of remote end and secret, so the sequence of other
+ *        connections is not guessed by remote host. The secret is
+ *        stirred by cycle counter on each SYN: the time of arrival
+ *        in cycles is not known out of board.
+ * @param [in] ipAddr - IP address of remote end
+ * @param [in] port - port of remote end
+ * @retval initial sequence
+ */
+uint32_t TcpEngine::makeInitialSequence(uint32_t ipAddr, uint16_t port)
+{
+    _secret = mix(_secret ^ CycleCounter::now());
+    const uint32_t ports = (static_cast<uint32_t>(port) << 16) | _port;
+    return mix(mix(_secret ^ ipAddr) ^ ports) + (_now * SEQUENCE_CLOCK);
+}
+
+/**
+ * @brief Find open connection of remote end
+ * @retval pointer on connection, nullptr if it is not found
+ */
+TcpConnection* TcpEngine::findConnection(uint32_t ipAddr, uint16_t port)
+{
+    for(size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+        TcpConnection* connection = &_connections[i];
+        if((connection->_state != TcpConnection::State::CLOSED) &&
+            (connection->_remoteIp == ipAddr) &&
+            (connection->_remotePort == port)) {
+            return connection;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Open connection by received SYN, its MAC address is taken
+ *        from frame (there is not ARP cache)
+ * @param [in] frame - frame of SYN
+ * @retval pointer on connection in SYN_RECEIVED state, nullptr if table
+ *         is full (without connections in TIME_WAIT)
+ */
+TcpConnection* TcpEngine::openConnection(uint8_t* frame)
+{
+    // the slot in TIME_WAIT is taken over if there is not free one
+    TcpConnection* connection = nullptr;
+    for(size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+        if(TcpConnection::State::CLOSED == _connections[i]._state) {
+            connection = &_connections[i];
+            break;
+        }
+        if((TcpConnection::State::TIME_WAIT == _connections[i]._state) &&
+            (nullptr == connection)) {
+            connection = &_connections[i];
+        }
+    }
+    if(nullptr == connection) {
+        return nullptr;
+    }
+
+    const TcpHeader tcp(&frame[Ethernet::TRANSPORT_P]);
+    memcpy(connection->_remoteMac,
+        Ethernet::EthHeader(frame).getSrcMac(),
+        NetDevice::MAC_ADDR_SIZE);
+    connection->_remoteIp =
+        Ethernet::IpHeader(&frame[Ethernet::IP_P]).getSrcIp();
+    connection->_remotePort = tcp.getSrcPort();
+
+    const uint16_t mss = parseMss(tcp);
+    connection->_mss = (mss < MSS) ? mss : MSS;
+    connection->_sendWindow = tcp.getWindow();
+    connection->_receiveNext = tcp.getSequence() + 1;
+
+    // SYN takes one sequence number
+    const uint32_t sequence =
+        makeInitialSequence(connection->_remoteIp, connection->_remotePort);
+    connection->_sendUnacked = sequence;
+    connection->_sendNext = sequence + 1;
+
+    connection->_state = TcpConnection::State::SYN_RECEIVED;
+    connection->_retries = 0;
+    connection->_isAckPending = false;
+    connection->_deadline = _now + RTO_MS;
+    return connection;
+}
+
+/**
+ * @brief Build headers of segment with acknowledge of received data
+ * @param [in] frame - buffer of frame, the data follows headers
+ * @param [in] connection - connection (remote end)
+ * @param [in] sequence - sequence of segment
+ * @param [in] flags - flags of segment, SYN adds MSS option
+ * @param [in] dataLen - length of data
+ * @param [in] dataSum - sum of data (see Ethernet::SumWords)
+ * @retval length of frame
+ */
+size_t TcpEngine::buildSegment(uint8_t* frame,
+    TcpConnection* connection,
+    uint32_t sequence,
+    uint8_t flags,
+    size_t dataLen,
+    uint16_t dataSum)
+{
+    const size_t optionsLen =
+        (flags & TcpHeader::FLAG_SYN) ? OPTION_MSS_SIZE : 0;
+    const size_t tcpLen = TcpHeader::SIZE + optionsLen + dataLen;
+    Ethernet::MakeIpFrame(frame,
+        connection->_remoteMac,
+        _stack->getDevice()->getMacAddr(),
+        connection->_remoteIp,
+        _stack->getIpAddr(),
+        Ethernet::IpHeader::PROTOCOL_TCP,
+        Ethernet::IpHeader::SIZE + tcpLen,
+        _stack->getNextIpId());
+
+    TcpHeader tcp(&frame[Ethernet::TRANSPORT_P]);
+    tcp.setSrcPort(_port);
+    tcp.setDstPort(connection->_remotePort);
+    tcp.setSequence(sequence);
+    tcp.setAcknowledge(
+        (flags & TcpHeader::FLAG_ACK) ? connection->_receiveNext : 0);
+    tcp.setHeaderLen(TcpHeader::SIZE + optionsLen);
+    tcp.setFlags(flags);
+    tcp.setWindow(RECEIVE_WINDOW);
+    tcp.setChecksum(0);
+    tcp.setUrgentPtr(0);
+    if(optionsLen != 0) {
+        uint8_t* option = &tcp.data()[TcpHeader::OPTIONS];
+        option[0] = OPTION_MSS;
+        option[1] = OPTION_MSS_SIZE;
+        Ethernet::putWord16(&option[2], MSS);
+    }
+    // only the headers are summed, the sum of data is given
+    tcp.setChecksum(Ethernet::CalcTransportChecksum(frame,
+        TcpHeader::SIZE + optionsLen,
+        dataLen,
+        dataSum,
+        Ethernet::PacketType_t::TCP));
+
+    if(flags & TcpHeader::FLAG_ACK) {
+        connection->_isAckPending = false;
+    }
+    return Ethernet::TRANSPORT_P + tcpLen;
+}
+
+/**
+ * @brief Send segment without data, it is built on stack (not in pool)
+ * @param [in] connection - connection
+ * @param [in] flags - flags of segment: SYN and FIN take sequence
+ *        before the next one
+ */
+void TcpEngine::sendControl(TcpConnection* connection, uint8_t flags)
+{
+    uint8_t frame[HEADERS_SIZE + OPTION_MSS_SIZE];
+    const uint32_t sequence =
+        (flags & (TcpHeader::FLAG_SYN | TcpHeader::FLAG_FIN)) ?
+            (connection->_sendNext - 1) :
+            connection->_sendNext;
+    const size_t len = buildSegment(frame, connection, sequence, flags, 0, 0);
+    _stack->getDevice()->send(frame, len);
+}
+
+/**
+ * @brief Send probe of zero window: the sequence before acknowledged one
+ *        is not acceptable, so the peer answers with its window
+ * @param [in] connection - connection
+ */
+void TcpEngine::sendProbe(TcpConnection* connection)
+{
+    uint8_t frame[HEADERS_SIZE];
+    const size_t len = buildSegment(frame,
+        connection,
+        connection->_sendUnacked - 1,
+        TcpHeader::FLAG_ACK,
+        0,
+        0);
+    _stack->getDevice()->send(frame, len);
+}
+
+/**
+ * @brief Reset segment without connection (RFC 793, "Reset Generation")
+ * @param [in] frame - received frame, it is not changed
+ * @param [in] tcpLen - length of TCP header and data
+ */
+void TcpEngine::sendReset(uint8_t* frame, size_t tcpLen)
+{
+    const TcpHeader tcp(&frame[Ethernet::TRANSPORT_P]);
+    const uint8_t flags = tcp.getFlags();
+    if(flags & TcpHeader::FLAG_RST) {
+        return;
+    }
+
+    TcpConnection peer;
+    memcpy(peer._remoteMac,
+        Ethernet::EthHeader(frame).getSrcMac(),
+        NetDevice::MAC_ADDR_SIZE);
+    peer._remoteIp = Ethernet::IpHeader(&frame[Ethernet::IP_P]).getSrcIp();
+    peer._remotePort = tcp.getSrcPort();
+    peer._receiveNext = 0;
+
+    uint8_t reply[HEADERS_SIZE];
+    size_t len = 0;
+    if(flags & TcpHeader::FLAG_ACK) {
+        // the sequence is taken from acknowledge of segment
+        len = buildSegment(
+            reply, &peer, tcp.getAcknowledge(), TcpHeader::FLAG_RST, 0, 0);
+    }
+    else {
+        // the segment is acknowledged, SYN and FIN take one number
+        peer._receiveNext = tcp.getSequence() + tcpLen - tcp.getHeaderLen();
+        if(flags & TcpHeader::FLAG_SYN) {
+            ++peer._receiveNext;
+        }
+        if(flags & TcpHeader::FLAG_FIN) {
+            ++peer._receiveNext;
+        }
+        len = buildSegment(reply,
+            &peer,
+            0,
+            TcpHeader::FLAG_RST | TcpHeader::FLAG_ACK,
+            0,
+            0);
+    }
+    _stack->getDevice()->send(reply, len);
+    ++_statistics.resets;
+}
+
+/**
+ * @brief Process acknowledge: the acknowledged segments are released,
+ *        the probe of zero window is started
+ * @param [in] connection - connection
+ * @param [in] ack - acknowledge of segment
+ * @param [in] window - window of segment
+ * @retval true - data of some segment is acknowledged or window is opened
+ */
+bool TcpEngine::acknowledge(TcpConnection* connection,
+    uint32_t ack,
+    uint16_t window)
+{
+    // the acknowledge of not sent data or an old one is ignored
+    if(isBefore(connection->_sendNext, ack) ||
+        isBefore(ack, connection->_sendUnacked)) {
+        return false;
+    }
+    const bool isOpened = window > connection->_sendWindow;
+    const bool isSending =
+        (TcpConnection::State::ESTABLISHED == connection->_state) ||
+        (TcpConnection::State::CLOSE_WAIT == connection->_state);
+    // the zero window is probed from now on (see tick())
+    if(isSending && (0 == window) &&
+        ((connection->_sendWindow != 0) || (ack != connection->_sendUnacked))) {
+        connection->_retries = 0;
+        connection->_deadline = _now + RTO_MS;
+    }
+    connection->_sendWindow = window;
+    if(ack == connection->_sendUnacked) {
+        return isOpened;
+    }
+    connection->_sendUnacked = ack;
+
+    bool isReleased = isOpened;
+    PacketPool* pool = _stack->getPool();
+    for(size_t i = 0; i < RETRANSMIT_SLOTS; ++i) {
+        Segment& segment = _segments[i];
+        if((segment.buffer != nullptr) && (segment.connection == connection) &&
+            !isBefore(ack, segment.sequenceEnd)) {
+            pool->release(segment.buffer);
+            segment.buffer = nullptr;
+            isReleased = true;
+        }
+    }
+    return isReleased;
+}
+
+/**
+ * @brief Notify sending connections about free send space: the slots
+ *        of retransmit queue are shared, so the freed slot is offered
+ *        to all connections, beginning with acknowledged one
+ * @param [in] first - acknowledged connection
+ */
+void TcpEngine::notifySent(TcpConnection* first)
+{
+    for(size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+        TcpConnection* connection =
+            &_connections[(first->_index + i) % MAX_CONNECTIONS];
+        if(getSendSpace(connection) != 0) {
+            _application->onSent(this, connection);
+        }
+    }
+}
+
+/**
+ * @brief Process FIN of peer: the passive close answers with own FIN
+ *        if application has nothing more to send (see onFin())
+ * @param [in] connection - connection
+ */
+void TcpEngine::receiveFin(TcpConnection* connection)
+{
+    // FIN takes one sequence number
+    connection->_receiveNext += 1;
+    connection->_isAckPending = true;
+
+    switch(connection->_state) {
+        case TcpConnection::State::ESTABLISHED:
+            connection->_state = TcpConnection::State::CLOSE_WAIT;
+            if(_application->onFin(this, connection)) {
+                close(connection);
+            }
+            break;
+
+        case TcpConnection::State::FIN_WAIT_1:
+            // own FIN is not acknowledged yet
+            connection->_state = TcpConnection::State::CLOSING;
+            break;
+
+        case TcpConnection::State::FIN_WAIT_2:
+            connection->_state = TcpConnection::State::TIME_WAIT;
+            connection->_deadline = _now + TIME_WAIT_MS;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Free slot of connection and its queued segments
+ * @param [in] connection - connection
+ * @param [in] isNotified - onClose() of application is called
+ */
+void TcpEngine::release(TcpConnection* connection, bool isNotified)
+{
+    PacketPool* pool = _stack->getPool();
+    for(size_t i = 0; i < RETRANSMIT_SLOTS; ++i) {
+        Segment& segment = _segments[i];
+        if((segment.buffer != nullptr) && (segment.connection == connection)) {
+            pool->release(segment.buffer);
+            segment.buffer = nullptr;
+        }
+    }
+    if(isNotified) {
+        _application->onClose(this, connection);
+    }
+    connection->_state = TcpConnection::State::CLOSED;
+}
@@ -0,0 +1,308 @@
+/**
+ ******************************************************************************
+ * @file    tcp_engine.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the TCP server over protocol stack:
+ *          static table of connections, handshake, in-order receive
+ *          and retransmit queue of sent segments.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TCP_ENGINE_HPP
+#define __TCP_ENGINE_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "net_stack.hpp"
+#include "packet_pool.hpp"
+#include "ethernet.hpp"
+#include "cycle_counter.hpp"
+
+class TcpEngine;
+
+/**
+ * @brief Connection of TCP engine, the fields are changed by engine only
+ */
+class TcpConnection {
+  public:
+    enum class State : uint8_t {
+        CLOSED,    ///< slot of table is free
+        SYN_RECEIVED,
+        ESTABLISHED,
+        FIN_WAIT_1,
+        FIN_WAIT_2,
+        CLOSING,
+        TIME_WAIT,
+        CLOSE_WAIT,
+        LAST_ACK
+    };
+
+    State getState() const
+    {
+        return _state;
+    }
+
+    uint32_t getRemoteIp() const
+    {
+        return _remoteIp;
+    }
+
+    uint16_t getRemotePort() const
+    {
+        return _remotePort;
+    }
+
+    /// Index in table of engine, for state of application per connection
+    size_t getIndex() const
+    {
+        return _index;
+    }
+
+    /// Maximum data of sent segment (of peer)
+    size_t getMss() const
+    {
+        return _mss;
+    }
+
+  private:
+    friend class TcpEngine;
+
+    State _state;
+
+    uint8_t _index;
+
+    uint8_t _retries;    ///< Retransmits of SYN or FIN, probes of window
+
+    bool _isAckPending;    ///< Received data is not acknowledged yet
+
+    uint8_t _remoteMac[NetDevice::MAC_ADDR_SIZE];
+
+    uint32_t _remoteIp;
+
+    uint16_t _remotePort;
+
+    uint16_t _mss;
+
+    uint16_t _sendWindow;    ///< Window of peer
+
+    uint32_t _sendUnacked;    ///< Oldest sent sequence not acknowledged
+
+    uint32_t _sendNext;    ///< Next sent sequence
+
+    uint32_t _receiveNext;    ///< Next expected sequence
+
+    uint32_t _deadline;    ///< Time of retransmit, of window probe, of release
+};
+
+/**
+ * @brief Application over TCP engine, called from poll() of stack
+ *        and from tick() of engine
+ */
+class TcpApplication {
+  public:
+    virtual ~TcpApplication() = default;
+
+    virtual void onConnect(TcpEngine*, TcpConnection*) {}
+
+    /**
+     * @brief Process received data, it is not copied out of frame
+     * @param [in] engine - engine of connection
+     * @param [in] connection - connection of data
+     * @param [in] data - pointer on data in frame buffer, valid during call
+     * @param [in] len - length of data
+     */
+    virtual void onReceive(TcpEngine* engine,
+        TcpConnection* connection,
+        const uint8_t* data,
+        size_t len) = 0;
+
+    /// The sent data is acknowledged (of this or other connection)
+    /// or window of peer is opened, more data may be sent
+    virtual void onSent(TcpEngine*, TcpConnection*) {}
+
+    /**
+     * @brief The peer has sent all its data (FIN)
+     * @retval true - the connection is closed now, false - the application
+     *         sends the rest of its data and closes it later
+     */
+    virtual bool onFin(TcpEngine*, TcpConnection*)
+    {
+        return true;
+    }
+
+    /// The connection is reset or timed out, it is released after the call
+    virtual void onClose(TcpEngine*, TcpConnection*) {}
+};
+
+/**
+ * @brief Class of TCP server on port of stack (Config::tcpPort).
+ *        The connections and the retransmit queue are static tables,
+ *        the sent segments are kept in buffers of pool until they are
+ *        acknowledged. The received data is delivered in order only,
+ *        other segments are dropped and acknowledged again.
+ *        The initial sequence is unpredictable if CycleCounter is enabled
+ *        by application (see makeInitialSequence()).
+ */
+class TcpEngine final
+    : private NonCopyable<TcpEngine>
+    , private NonMovable<TcpEngine>
+    , public NetHandler {
+  public:
+    static constexpr size_t MAX_CONNECTIONS = 4;
+
+    /// Sent segments waiting for acknowledge, the pool must have
+    /// one buffer more for received frame (checked by NetConfig)
+    static constexpr size_t RETRANSMIT_SLOTS = 2;
+
+    /// Room for ethernet, IP and TCP headers (without options) before data
+    static constexpr size_t HEADERS_SIZE =
+        Ethernet::TRANSPORT_P + Ethernet::TcpHeader::SIZE;
+
+    /// Maximum segment (advertised by SYN): the frame (received one with
+    /// its headroom) must fit buffer of pool and the frame with its CRC
+    /// must not exceed frame limit of MAC
+    static constexpr size_t MSS =
+        ((PacketBuffer::SIZE - NetStack::RX_HEADROOM - HEADERS_SIZE) <
+            (Ethernet::MAX_FRAME_SIZE - Ethernet::CRC_SIZE - HEADERS_SIZE)) ?
+            (PacketBuffer::SIZE - NetStack::RX_HEADROOM - HEADERS_SIZE) :
+            (Ethernet::MAX_FRAME_SIZE - Ethernet::CRC_SIZE - HEADERS_SIZE);
+
+    /// Window of receive: data is delivered to application at once
+    static constexpr uint16_t RECEIVE_WINDOW = 2 * MSS;
+
+    struct Statistics {
+        uint32_t accepted;    ///< Opened connections
+        uint32_t refused;    ///< Dropped SYN, table of connections is full
+        uint32_t resets;    ///< Sent and received RST
+        uint32_t retransmits;
+        uint32_t probes;    ///< Probes of zero window
+        uint32_t timeouts;    ///< Connections closed by retransmit limit
+        uint32_t errors;    ///< Invalid checksum or length
+        uint32_t outOfOrder;    ///< Dropped segments not in order
+    };
+
+    TcpEngine(NetStack*, TcpApplication*);
+
+    ~TcpEngine();
+
+    bool listen();
+
+    void stop();
+
+    PacketBuffer* allocate();
+
+    bool sendBuffer(TcpConnection*, PacketBuffer*);
+
+    bool sendBuffer(TcpConnection*, PacketBuffer*, uint16_t);
+
+    size_t send(TcpConnection*, const uint8_t*, size_t);
+
+    size_t getSendSpace(const TcpConnection*) const;
+
+    void close(TcpConnection*);
+
+    void abort(TcpConnection*);
+
+    void tick(uint32_t);
+
+    bool handle(NetStack*, PacketBuffer*, const Ethernet::FrameInfo&) override;
+
+    NetStack* getStack() const;
+
+    size_t getConnectionCount() const;
+
+    const Statistics& getStatistics() const;
+
+    void resetStatistics();
+
+  private:
+    enum Default {
+        SEQUENCE_CLOCK = 250,    ///< clock of initial sequence per ms (4 us)
+        RTO_MS = 250,    ///< first retransmit timeout, doubled on retry
+        MAX_RETRIES = 6,
+        TIME_WAIT_MS = 1000,    ///< short, to free slot of table soon
+        FIN_WAIT_MS = 10000,    ///< wait of FIN of peer
+        DEFAULT_MSS = 536,    ///< MSS of peer without option
+        OPTION_END = 0,
+        OPTION_NOP = 1,
+        OPTION_MSS = 2,
+        OPTION_MSS_SIZE = 4
+    };
+
+    /// Sent segment of retransmit queue, free if buffer is nullptr
+    struct Segment {
+        TcpConnection* connection;
+        PacketBuffer* buffer;    ///< Whole frame of segment
+        uint32_t sequenceEnd;    ///< Sequence after data of segment
+        uint32_t deadline;
+        uint8_t retries;
+    };
+
+    TcpEngine() = delete;
+
+    static bool isBefore(uint32_t, uint32_t);
+
+    static uint16_t parseMss(const Ethernet::TcpHeader&);
+
+    static uint32_t mix(uint32_t);
+
+    uint32_t makeInitialSequence(uint32_t, uint16_t);
+
+    TcpConnection* findConnection(uint32_t, uint16_t);
+
+    TcpConnection* openConnection(uint8_t*);
+
+    size_t buildSegment(uint8_t*,
+        TcpConnection*,
+        uint32_t,
+        uint8_t,
+        size_t,
+        uint16_t);
+
+    void sendControl(TcpConnection*, uint8_t);
+
+    void sendProbe(TcpConnection*);
+
+    void sendReset(uint8_t*, size_t);
+
+    bool acknowledge(TcpConnection*, uint32_t, uint16_t);
+
+    void notifySent(TcpConnection*);
+
+    void receiveFin(TcpConnection*);
+
+    void release(TcpConnection*, bool);
+
+    NetStack* const _stack;
+
+    TcpApplication* const _application;
+
+    uint16_t _port;    ///< Listened port, zero - stopped
+
+    uint32_t _now;    ///< Time of last tick, milliseconds
+
+    uint32_t _secret;    ///< Key of initial sequence, stirred by each SYN
+
+    TcpConnection _connections[MAX_CONNECTIONS];
+
+    Segment _segments[RETRANSMIT_SLOTS];
+
+    Statistics _statistics;
+};
+
+#endif
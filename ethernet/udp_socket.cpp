@@ -0,0 +1,219 @@
+/**
+ ******************************************************************************
+ * @file    udp_socket.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the UDP sockets over protocol stack.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "udp_socket.hpp"
+
+/**
+ * @brief Constructor
+ * @param [in] stack - protocol stack
+ * @param [in] receiver - receiver of datagrams, nullptr - send only
+ */
+UdpSocket::UdpSocket(NetStack* stack, UdpReceiver* receiver) :
+    _stack(stack),
+    _receiver(receiver),
+    _port(0)
+{
+    resetStatistics();
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+}
+
+/**
+ * @brief Bind socket to local port, the previous port is closed
+ * @param [in] port - local port, not zero
+ * @retval true - socket is bound, false - port is zero, it is bound by
+ *         other socket (the socket is not changed) or table is full
+ */
+bool UdpSocket::bind(uint16_t port)
+{
+    NetHandler* owner = _stack->getHandler(Ethernet::Protocol::UDP, port);
+    if((owner != nullptr) && (owner != this)) {
+        return false;
+    }
+
+    close();
+    if((0 == port) ||
+        !_stack->addHandler(Ethernet::Protocol::UDP, port, this)) {
+        return false;
+    }
+    _port = port;
+    return true;
+}
+
+/**
+ * @brief Unbind socket, the datagrams to its port are dropped
+ */
+void UdpSocket::close()
+{
+    if(0 == _port) {
+        return;
+    }
+    // the port may be registered again by other handler of stack
+    if(this == _stack->getHandler(Ethernet::Protocol::UDP, _port)) {
+        _stack->removeHandler(Ethernet::Protocol::UDP, _port);
+    }
+    _port = 0;
+}
+
+uint16_t UdpSocket::getPort() const
+{
+    return _port;
+}
+
+/**
+ * @brief Get buffer for data of datagram, the data is written from
+ *        payload() and its length is set in len
+ * @retval pointer on buffer with headroom for headers, nullptr if pool
+ *         is empty
+ */
+PacketBuffer* UdpSocket::allocate()
+{
+    return _stack->getPool()->allocate(HEADERS_SIZE);
+}
+
+/**
+ * @brief Send datagram, the headers are built in headroom of buffer
+ * @param [in] to - receiver of datagram
+ * @param [in] buffer - buffer of data (see allocate()), it is released
+ * @retval true - datagram is sent
+ */
+bool UdpSocket::sendTo(const UdpEndpoint& to, PacketBuffer* buffer)
+{
+    PacketPool* pool = _stack->getPool();
+    if((0 == _port) || (buffer->headroom() < HEADERS_SIZE) ||
+        (buffer->len > MAX_DATA_SIZE)) {
+        ++_statistics.sendErrors;
+        pool->release(buffer);
+        return false;
+    }
+
+    const size_t udpLen = Ethernet::UdpHeader::SIZE + buffer->len;
+    uint8_t* frame = buffer->prepend(HEADERS_SIZE);
+    NetDevice* device = _stack->getDevice();
+    Ethernet::MakeIpFrame(frame,
+        to.macAddr,
+        device->getMacAddr(),
+        to.ipAddr,
+        _stack->getIpAddr(),
+        Ethernet::IpHeader::PROTOCOL_UDP,
+        Ethernet::IpHeader::SIZE + udpLen,
+        _stack->getNextIpId());
+
+    Ethernet::UdpHeader udp(&frame[Ethernet::TRANSPORT_P]);
+    udp.setSrcPort(_port);
+    udp.setDstPort(to.port);
+    udp.setLen(udpLen);
+    udp.setChecksum(0);
+    const uint16_t checksum = Ethernet::CalcTransportChecksum(
+        frame, udpLen, Ethernet::PacketType_t::UDP);
+    // zero means that sender has not computed checksum
+    udp.setChecksum((0 == checksum) ? 0xFFFF : checksum);
+
+    device->send(frame, buffer->len);
+    pool->release(buffer);
+    ++_statistics.sent;
+    return true;
+}
+
+/**
+ * @brief Send datagram, the data is copied into buffer of pool
+ * @param [in] to - receiver of datagram
+ * @param [in] data - pointer on data
+ * @param [in] len - length of data
+ * @retval true - datagram is sent
+ */
+bool UdpSocket::sendTo(const UdpEndpoint& to, const uint8_t* data, size_t len)
+{
+    PacketBuffer* buffer = allocate();
+    if(nullptr == buffer) {
+        ++_statistics.sendErrors;
+        return false;
+    }
+    if(len > buffer->tailroom()) {
+        len = buffer->tailroom();
+    }
+    memcpy(buffer->payload(), data, len);
+    buffer->len = len;
+    return sendTo(to, buffer);
+}
+
+/**
+ * @brief Process received datagram of bound port: the rest of frame is
+ *        read from device, then the data is passed to receiver in place
+ */
+bool UdpSocket::handle(NetStack* stack,
+    PacketBuffer* buffer,
+    const Ethernet::FrameInfo& info)
+{
+    NetDevice* device = stack->getDevice();
+    Profiler& profiler = device->getProfiler();
+    uint8_t* frame = buffer->payload();
+
+    profiler.begin(Instrumentation::STAGE_RECEIVE);
+    device->fetch(frame);
+    profiler.end(Instrumentation::STAGE_RECEIVE);
+
+    const Ethernet::UdpHeader udp(&frame[Ethernet::TRANSPORT_P]);
+    const size_t udpLen = udp.getLen();
+    if((udpLen < Ethernet::UdpHeader::SIZE) ||
+        ((Ethernet::TRANSPORT_P + udpLen) > info.len)) {
+        ++_statistics.receiveErrors;
+        return false;
+    }
+    // zero - the sender has not computed checksum
+    profiler.begin(Instrumentation::STAGE_CLASSIFY);
+    const bool isValid = (0 == udp.getChecksum()) ||
+                         (0 ==
+                             Ethernet::CalcTransportChecksum(frame,
+                                 udpLen,
+                                 Ethernet::PacketType_t::UDP));
+    profiler.end(Instrumentation::STAGE_CLASSIFY);
+    if(!isValid) {
+        ++_statistics.receiveErrors;
+        return false;
+    }
+
+    ++_statistics.received;
+    if(_receiver != nullptr) {
+        UdpEndpoint from;
+        memcpy(from.macAddr,
+            Ethernet::EthHeader(frame).getSrcMac(),
+            NetDevice::MAC_ADDR_SIZE);
+        from.ipAddr = Ethernet::IpHeader(&frame[Ethernet::IP_P]).getSrcIp();
+        from.port = udp.getSrcPort();
+
+        profiler.begin(Instrumentation::STAGE_REPLY);
+        _receiver->receive(this,
+            from,
+            &frame[HEADERS_SIZE],
+            udpLen - Ethernet::UdpHeader::SIZE);
+        profiler.end(Instrumentation::STAGE_REPLY);
+    }
+    return true;
+}
+
+const UdpSocket::Statistics& UdpSocket::getStatistics() const
+{
+    return _statistics;
+}
+
+void UdpSocket::resetStatistics()
+{
+    memset(&_statistics, 0, sizeof(_statistics));
+}
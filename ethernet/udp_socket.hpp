@@ -0,0 +1,127 @@
+/**
+ ******************************************************************************
+ * @file    udp_socket.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the UDP sockets over protocol stack.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UDP_SOCKET_HPP
+#define __UDP_SOCKET_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "net_stack.hpp"
+#include "packet_pool.hpp"
+#include "ethernet.hpp"
+
+/**
+ * @brief Remote end of UDP datagram. There is not ARP cache, so the MAC
+ *        address is taken from received datagram or set by application
+ *        (of receiver, of gateway or broadcast).
+ */
+struct UdpEndpoint {
+    uint8_t macAddr[NetDevice::MAC_ADDR_SIZE];
+    uint32_t ipAddr;    ///< See Ethernet::makeIpAddr
+    uint16_t port;
+};
+
+class UdpSocket;
+
+/**
+ * @brief Receiver of datagrams of UDP socket
+ */
+class UdpReceiver {
+  public:
+    virtual ~UdpReceiver() = default;
+
+    /**
+     * @brief Process received datagram, it is not copied out of frame
+     * @param [in] socket - socket of datagram
+     * @param [in] from - sender of datagram
+     * @param [in] data - pointer on data in frame buffer, valid during call
+     * @param [in] len - length of data
+     */
+    virtual void receive(UdpSocket* socket,
+        const UdpEndpoint& from,
+        const uint8_t* data,
+        size_t len) = 0;
+};
+
+/**
+ * @brief Class of UDP socket. The bound port is registered in handler
+ *        table of stack, so the port is found in constant time.
+ *        The datagram is sent from buffer of pool, its headers are built
+ *        in headroom of buffer.
+ */
+class UdpSocket final
+    : private NonCopyable<UdpSocket>
+    , private NonMovable<UdpSocket>
+    , public NetHandler {
+  public:
+    /// Room for ethernet, IP and UDP headers before data
+    static constexpr size_t HEADERS_SIZE =
+        Ethernet::TRANSPORT_P + Ethernet::UdpHeader::SIZE;
+
+    /// Maximum data of datagram: the frame with its CRC must not exceed
+    /// frame limit of MAC (datagram is not fragmented)
+    static constexpr size_t MAX_DATA_SIZE =
+        Ethernet::MAX_FRAME_SIZE - Ethernet::CRC_SIZE - HEADERS_SIZE;
+
+    struct Statistics {
+        uint32_t received;
+        uint32_t sent;
+        uint32_t receiveErrors;    ///< Invalid length or checksum
+        uint32_t sendErrors;    ///< Not bound, too long or pool is empty
+    };
+
+    UdpSocket(NetStack*, UdpReceiver*);
+
+    ~UdpSocket();
+
+    bool bind(uint16_t);
+
+    void close();
+
+    uint16_t getPort() const;
+
+    PacketBuffer* allocate();
+
+    bool sendTo(const UdpEndpoint&, PacketBuffer*);
+
+    bool sendTo(const UdpEndpoint&, const uint8_t*, size_t);
+
+    bool handle(NetStack*, PacketBuffer*, const Ethernet::FrameInfo&) override;
+
+    const Statistics& getStatistics() const;
+
+    void resetStatistics();
+
+  private:
+    UdpSocket() = delete;
+
+    NetStack* const _stack;
+
+    UdpReceiver* const _receiver;
+
+    uint16_t _port;    ///< Bound port, zero - socket is closed
+
+    Statistics _statistics;
+};
+
+#endif
@@ -0,0 +1,721 @@
+/**
+ ******************************************************************************
+ * @file    enc28j60_sim.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the behavioral model of ENC28J60 for host.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "enc28j60_sim.hpp"
+#include "utils/spi_interface.hpp"
+#include "ethernet/cycle_counter.hpp"
+
+Enc28j60Sim::Enc28j60Sim() :
+    _state(STATE_IDLE),
+    _address(0),
+    _isDummy(false),
+    _isLinkUp(true),
+    _isInterrupt(false),
+    _observer(nullptr),
+    _txHead(0),
+    _txCount(0),
+    _cost(),
+    _prescaler(1),
+    _overflows(0)
+{
+    memset(_sram, 0, sizeof(_sram));
+    reset();
+}
+
+/**
+ * @brief Set registers to values after reset (see datasheet),
+ *        the buffer memory is not changed
+ */
+void Enc28j60Sim::reset()
+{
+    memset(_banks, 0, sizeof(_banks));
+    memset(_phy, 0, sizeof(_phy));
+
+    setPointer(ERDPTL, 0x05FA);
+    setPointer(ERXSTL, 0x05FA);
+    setPointer(ERXNDL, 0x1FFF);
+    setPointer(ERXRDPTL, 0x05FA);
+    _banks[1][ERXFCON] = 0xA1;
+    _banks[2][MACON2] = 0x80;
+    _banks[2][MAMXFLL] = MAX_FRAME_RESET & 0xFF;
+    _banks[2][MAMXFLH] = MAX_FRAME_RESET >> 8;
+    _banks[3][EREVID] = REVISION;
+    _banks[0][ESTAT] = ESTAT_CLKRDY;
+    _banks[0][ECON2] = ECON2_AUTOINC;
+
+    _isInterrupt = false;
+}
+
+/**
+ * @brief Chip select
+ * @param [in] isSelect - true - CS is asserted
+ */
+void Enc28j60Sim::select(bool isSelect)
+{
+    if(isSelect) {
+        ++_cost.transactions;
+        _state = STATE_OPCODE;
+    }
+    else {
+        _state = STATE_IDLE;
+    }
+}
+
+bool Enc28j60Sim::isSelected() const
+{
+    return _state != STATE_IDLE;
+}
+
+/**
+ * @brief Exchange one byte of SPI
+ * @param [in] data - byte from master
+ * @retval byte from ENC28J60
+ */
+uint8_t Enc28j60Sim::transfer(uint8_t data)
+{
+    ++_cost.bytes;
+    CycleCounter::advance(8 * _prescaler);
+
+    uint8_t answer = 0xFF;
+    switch(_state) {
+        case STATE_OPCODE:
+            _address = data & 0x1F;
+            _state = STATE_DONE;
+            if(0xFF == data) {
+                reset();
+            }
+            else if(0x3A == data) {
+                _state = STATE_READ_BUF;
+            }
+            else if(0x7A == data) {
+                _state = STATE_WRITE_BUF;
+            }
+            else if(0x00 == (data & 0xE0)) {
+                _state = STATE_READ_REG;
+                _isDummy = isMacRegister(_address);
+            }
+            else if(0x40 == (data & 0xE0)) {
+                _state = STATE_WRITE_REG;
+            }
+            else if(0x80 == (data & 0xE0)) {
+                _state = STATE_BIT_SET;
+            }
+            else if(0xA0 == (data & 0xE0)) {
+                _state = STATE_BIT_CLR;
+            }
+            break;
+
+        case STATE_READ_REG:
+            if(_isDummy) {
+                _isDummy = false;
+            }
+            else {
+                answer = readRegister(_address);
+            }
+            break;
+
+        case STATE_READ_BUF: {
+            const uint16_t ptr = getPointer(ERDPTL);
+            answer = _sram[ptr];
+            if(reg(ECON2) & ECON2_AUTOINC) {
+                // the read pointer wraps from ERXND to ERXST
+                setPointer(ERDPTL,
+                    (ptr == getPointer(ERXNDL)) ?
+                        getPointer(ERXSTL) :
+                        ((ptr + 1) & (BUFFER_SIZE - 1)));
+            }
+            break;
+        }
+
+        case STATE_WRITE_REG:
+            writeRegister(_address, data);
+            _state = STATE_DONE;
+            break;
+
+        case STATE_WRITE_BUF: {
+            const uint16_t ptr = getPointer(EWRPTL);
+            _sram[ptr] = data;
+            if(reg(ECON2) & ECON2_AUTOINC) {
+                setPointer(EWRPTL, (ptr + 1) & (BUFFER_SIZE - 1));
+            }
+            break;
+        }
+
+        case STATE_BIT_SET:
+            writeRegister(_address, reg(_address) | data);
+            _state = STATE_DONE;
+            break;
+
+        case STATE_BIT_CLR:
+            writeRegister(_address, reg(_address) & ~data);
+            _state = STATE_DONE;
+            break;
+
+        default:
+            break;
+    }
+    return answer;
+}
+
+/**
+ * @brief Set observer of INT pin, it is called on falling edge
+ * @param [in] observer - pointer on observer
+ */
+void Enc28j60Sim::attach(SubjectObserver* observer)
+{
+    _observer = observer;
+}
+
+/**
+ * @brief Receive frame from network into RX ring
+ * @param [in] frame - pointer on frame (without CRC)
+ * @param [in] len - length of frame
+ * @retval false if frame is dropped (receive is off, frame is longer
+ *         than MAMXFL or ring is full)
+ */
+bool Enc28j60Sim::inject(const uint8_t* frame, size_t len)
+{
+    if(!(reg(ECON1) & ECON1_RXEN) || (len > FRAME_SIZE) ||
+        ((len + CRC_SIZE) > getMaxFrame()) || !isAccepted(frame, len)) {
+        return false;
+    }
+
+    const uint16_t start = getPointer(ERXSTL);
+    const uint16_t end = getPointer(ERXNDL);
+    const size_t size = end - start + 1;
+    const uint16_t write = getPointer(ERXWRPTL);
+    const uint16_t read = getPointer(ERXRDPTL);
+    // the hardware does not write over ERXRDPT
+    const size_t space =
+        (read >= write) ? (read - write) : (size - (write - read));
+    // the next packet starts on even address
+    const size_t need = (RX_HEADER_SIZE + len + CRC_SIZE + 1) & ~1u;
+    if((need > space) || (0xFF == _banks[1][EPKTCNT])) {
+        ++_overflows;
+        reg(EIR) |= EIR_RXERIF;
+        updateInterrupt();
+        return false;
+    }
+
+    size_t next = write + need;
+    if(next > end) {
+        next -= size;
+    }
+
+    const uint32_t crc = crc32(frame, len);
+    const size_t byteCount = len + CRC_SIZE;
+    const bool isBroadcast = (0xFF == frame[0]) && (0xFF == frame[1]);
+    const bool isMulticast = (frame[0] & 0x01) && !isBroadcast;
+    const uint8_t header[RX_HEADER_SIZE] = { static_cast<uint8_t>(next),
+        static_cast<uint8_t>(next >> 8),
+        static_cast<uint8_t>(byteCount),
+        static_cast<uint8_t>(byteCount >> 8),
+        0x80,    // received ok
+        static_cast<uint8_t>((isBroadcast ? 0x02 : 0x00) |
+                             (isMulticast ? 0x01 : 0x00)) };
+
+    uint16_t ptr = write;
+    for(size_t i = 0; i < RX_HEADER_SIZE; ++i) {
+        _sram[ptr] = header[i];
+        ptr = nextRx(ptr);
+    }
+    for(size_t i = 0; i < len; ++i) {
+        _sram[ptr] = frame[i];
+        ptr = nextRx(ptr);
+    }
+    for(size_t i = 0; i < CRC_SIZE; ++i) {
+        _sram[ptr] = static_cast<uint8_t>(crc >> (8 * i));
+        ptr = nextRx(ptr);
+    }
+
+    setPointer(ERXWRPTL, next);
+    ++_banks[1][EPKTCNT];
+    updateInterrupt();
+    return true;
+}
+
+/**
+ * @brief Get the oldest transmitted frame
+ * @param [out] frame - buffer of frame
+ * @param [in] maxLen - size of buffer, longer frame is truncated
+ * @retval length of frame, zero if there is no transmitted frame
+ */
+size_t Enc28j60Sim::takeSent(uint8_t* frame, size_t maxLen)
+{
+    if(0 == _txCount) {
+        return 0;
+    }
+
+    size_t len = _txLengths[_txHead];
+    if(len > maxLen) {
+        len = maxLen;
+    }
+    memcpy(frame, _txFrames[_txHead], len);
+
+    _txHead = (_txHead + 1) % TX_QUEUE_SIZE;
+    --_txCount;
+    return len;
+}
+
+void Enc28j60Sim::setLink(bool isLinkUp)
+{
+    _isLinkUp = isLinkUp;
+}
+
+/**
+ * @brief Set SPI clock as divider of core clock: it gives the estimated
+ *        time and the cycles of host CycleCounter per SPI byte
+ * @param [in] prescaler - divider of SPI clock
+ */
+void Enc28j60Sim::setPrescaler(uint32_t prescaler)
+{
+    _prescaler = prescaler;
+}
+
+const Enc28j60Sim::Cost& Enc28j60Sim::getCost() const
+{
+    return _cost;
+}
+
+void Enc28j60Sim::resetCost()
+{
+    memset(&_cost, 0, sizeof(_cost));
+}
+
+/**
+ * @brief Estimated time of SPI traffic (without gaps between bytes)
+ * @param [in] coreClock - clock of SPI peripheral in Hz
+ * @retval time in nanoseconds
+ */
+uint64_t Enc28j60Sim::estimateNs(uint32_t coreClock) const
+{
+    return (static_cast<uint64_t>(_cost.bytes) * 8 * _prescaler *
+               1000000000ULL) /
+           coreClock;
+}
+
+uint32_t Enc28j60Sim::getOverflows() const
+{
+    return _overflows;
+}
+
+/**
+ * @brief Register as written by driver, without side effects of read
+ * @param [in] bank - bank of register (0..3)
+ * @param [in] address - address without bank
+ */
+uint8_t Enc28j60Sim::getRegister(uint8_t bank, uint8_t address) const
+{
+    const uint8_t common = (address >= COMMON_START) ? 0 : bank;
+    return _banks[common & (BANKS - 1)][address & (BANK_SIZE - 1)];
+}
+
+/**
+ * @brief PHY register as read by driver
+ * @param [in] address - PHY register
+ */
+uint16_t Enc28j60Sim::getPhy(uint8_t address) const
+{
+    return readPhy(address);
+}
+
+/**
+ * @brief Register of current bank (the common registers are in all banks)
+ * @param [in] address - address without bank
+ * @retval reference on register
+ */
+uint8_t& Enc28j60Sim::reg(uint8_t address)
+{
+    if(address >= COMMON_START) {
+        return _banks[0][address];
+    }
+    return _banks[_banks[0][ECON1] & ECON1_BSEL][address];
+}
+
+/**
+ * @brief Pointer of bank 0 (low and high registers)
+ * @param [in] address - address of low register
+ */
+uint16_t Enc28j60Sim::getPointer(uint8_t address)
+{
+    return (_banks[0][address] | (_banks[0][address + 1] << 8)) &
+           (BUFFER_SIZE - 1);
+}
+
+/**
+ * @brief Maximum frame length of MAC (with CRC)
+ */
+size_t Enc28j60Sim::getMaxFrame() const
+{
+    return _banks[2][MAMXFLL] | (_banks[2][MAMXFLH] << 8);
+}
+
+void Enc28j60Sim::setPointer(uint8_t address, uint16_t value)
+{
+    _banks[0][address] = value & 0xFF;
+    _banks[0][address + 1] = (value >> 8) & 0x1F;
+}
+
+/**
+ * @brief MAC and MII registers are read with dummy byte
+ * @param [in] address - address without bank
+ */
+bool Enc28j60Sim::isMacRegister(uint8_t address) const
+{
+    if(address >= COMMON_START) {
+        return false;
+    }
+    const uint8_t bank = _banks[0][ECON1] & ECON1_BSEL;
+    return (2 == bank) ||
+           ((3 == bank) && ((address <= 0x05) || (MISTAT == address)));
+}
+
+uint8_t Enc28j60Sim::readRegister(uint8_t address)
+{
+    if(EIR == address) {
+        // PKTIF follows the packet counter
+        return (reg(EIR) & ~EIR_PKTIF) |
+               ((_banks[1][EPKTCNT] != 0) ? EIR_PKTIF : 0);
+    }
+    return reg(address);
+}
+
+/**
+ * @brief Write register with its side effects
+ * @param [in] address - address without bank
+ * @param [in] data - value
+ */
+void Enc28j60Sim::writeRegister(uint8_t address, uint8_t data)
+{
+    const uint8_t bank =
+        (address >= COMMON_START) ? 0 : (_banks[0][ECON1] & ECON1_BSEL);
+    const uint8_t old = reg(address);
+
+    if(EIR == address) {
+        reg(EIR) = data & ~EIR_PKTIF;
+    }
+    else if(ESTAT == address) {
+        reg(ESTAT) = data | ESTAT_CLKRDY;
+    }
+    else if(ECON2 == address) {
+        if((data & ECON2_PKTDEC) && (_banks[1][EPKTCNT] != 0)) {
+            --_banks[1][EPKTCNT];
+        }
+        reg(ECON2) = data & ~ECON2_PKTDEC;
+    }
+    else if(ECON1 == address) {
+        if((data ^ old) & ECON1_BSEL) {
+            ++_cost.bankSwitches;
+        }
+        reg(ECON1) = data;
+        if(data & ECON1_RXRST) {
+            setPointer(ERXWRPTL, getPointer(ERXSTL));
+        }
+        if((data & ECON1_TXRTS) && !(old & ECON1_TXRTS)) {
+            transmit();
+        }
+        if(data & ECON1_DMAST) {
+            runDma();
+        }
+    }
+    else if(0 == bank) {
+        if((ERXWRPTL == address) || ((ERXWRPTL + 1) == address) ||
+            (EDMACSL == address) || (EDMACSH == address)) {
+            // read-only
+        }
+        else {
+            reg(address) = data;
+            if((ERXSTL == address) || (ERXSTH == address)) {
+                // the write pointer follows the start of ring
+                setPointer(ERXWRPTL, getPointer(ERXSTL));
+            }
+        }
+    }
+    else if(1 == bank) {
+        if(address != EPKTCNT) {
+            reg(address) = data;
+        }
+    }
+    else if(2 == bank) {
+        reg(address) = data;
+        if((MICMD == address) && (data & MICMD_MIIRD)) {
+            const uint16_t value = readPhy(_banks[2][MIREGADR]);
+            _banks[2][MIRDL] = value & 0xFF;
+            _banks[2][MIRDH] = value >> 8;
+        }
+        if(MIWRH == address) {
+            _phy[_banks[2][MIREGADR] & (PHY_SIZE - 1)] =
+                _banks[2][MIWRL] | (data << 8);
+        }
+    }
+    else {
+        if((address != EREVID) && (address != MISTAT)) {
+            reg(address) = data;
+        }
+    }
+
+    updateInterrupt();
+}
+
+/**
+ * @brief Read PHY register, the status registers follow link and duplex
+ * @param [in] address - PHY register
+ */
+uint16_t Enc28j60Sim::readPhy(uint8_t address) const
+{
+    switch(address) {
+        case PHSTAT1:
+            // both duplexes, latched link status
+            return 0x1000 | 0x0800 | (_isLinkUp ? 0x0004 : 0x0000);
+        case PHSTAT2:
+            return (_isLinkUp ? 0x0400 : 0x0000) |
+                   ((_phy[PHCON1] & 0x0100) ? 0x0200 : 0x0000);
+        case PHHID1:
+            return 0x0083;
+        case PHHID2:
+            return 0x1400;
+        default:
+            return _phy[address & (PHY_SIZE - 1)];
+    }
+}
+
+/**
+ * @brief Transmit frame from ETXST (control byte) to ETXND, the status
+ *        vector is written after the frame. The frame longer than MAMXFL
+ *        (with CRC) is aborted as giant.
+ */
+void Enc28j60Sim::transmit()
+{
+    const uint16_t start = getPointer(ETXSTL);
+    const uint16_t end = getPointer(ETXNDL);
+    const size_t len = (end > start) ? (end - start) : 0;
+    const bool isGiant =
+        (len > FRAME_SIZE) || ((len + CRC_SIZE) > getMaxFrame());
+
+    if(!isGiant && (_txCount < TX_QUEUE_SIZE)) {
+        const size_t tail = (_txHead + _txCount) % TX_QUEUE_SIZE;
+        memcpy(_txFrames[tail], &_sram[start + 1], len);
+        _txLengths[tail] = len;
+        ++_txCount;
+    }
+
+    // byte count, transmit done or giant
+    const uint8_t status[TX_STATUS_SIZE] = { static_cast<uint8_t>(len),
+        static_cast<uint8_t>(len >> 8),
+        static_cast<uint8_t>(isGiant ? 0x00 : 0x80),
+        static_cast<uint8_t>(isGiant ? 0x80 : 0x00),
+        0,
+        0,
+        0 };
+    for(size_t i = 0; i < TX_STATUS_SIZE; ++i) {
+        _sram[(end + 1 + i) & (BUFFER_SIZE - 1)] = status[i];
+    }
+
+    reg(ECON1) &= ~ECON1_TXRTS;
+    reg(EIR) |= EIR_TXIF;
+    if(isGiant) {
+        reg(EIR) |= EIR_TXERIF;
+        reg(ESTAT) |= ESTAT_TXABRT;
+    }
+}
+
+/**
+ * @brief Copy or checksum of buffer memory, the source wraps in RX ring
+ */
+void Enc28j60Sim::runDma()
+{
+    uint16_t ptr = getPointer(EDMASTL);
+    const uint16_t end = getPointer(EDMANDL);
+
+    if(reg(ECON1) & ECON1_CSUMEN) {
+        uint32_t sum = 0;
+        bool isHigh = true;
+        while(true) {
+            sum += isHigh ? (_sram[ptr] << 8) : _sram[ptr];
+            isHigh = !isHigh;
+            if(ptr == end) {
+                break;
+            }
+            ptr = nextRx(ptr);
+        }
+        while(sum >> 16) {
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        sum = ~sum & 0xFFFF;
+        _banks[0][EDMACSL] = sum & 0xFF;
+        _banks[0][EDMACSH] = sum >> 8;
+    }
+    else {
+        uint16_t dest = getPointer(EDMADSTL);
+        while(true) {
+            _sram[dest] = _sram[ptr];
+            dest = (dest + 1) & (BUFFER_SIZE - 1);
+            if(ptr == end) {
+                break;
+            }
+            ptr = nextRx(ptr);
+        }
+    }
+
+    reg(ECON1) &= ~ECON1_DMAST;
+    reg(EIR) |= EIR_DMAIF;
+}
+
+/**
+ * @brief Receive filters of ERXFCON (see datasheet 8.0). Without enabled
+ *        filters all frames are accepted, otherwise one of them (OR)
+ *        or all of them (AND) must accept the frame.
+ * @param [in] frame - pointer on frame without CRC
+ * @param [in] len - length of frame
+ */
+bool Enc28j60Sim::isAccepted(const uint8_t* frame, size_t len) const
+{
+    // MAADR1..MAADR6 of datasheet, first byte of address in MAADR1
+    static const uint8_t MAADR[MAC_SIZE] = {
+        0x04, 0x05, 0x02, 0x03, 0x00, 0x01
+    };
+
+    const uint8_t filters = _banks[1][ERXFCON];
+    const uint8_t enabled = filters &
+                            (ERXFCON_UCEN | ERXFCON_PMEN | ERXFCON_MPEN |
+                                ERXFCON_HTEN | ERXFCON_MCEN | ERXFCON_BCEN);
+    if(0 == enabled) {
+        return true;
+    }
+
+    bool isLocal = true;
+    bool isBroadcast = true;
+    for(size_t i = 0; i < MAC_SIZE; ++i) {
+        isLocal = isLocal && (frame[i] == _banks[3][MAADR[i]]);
+        isBroadcast = isBroadcast && (0xFF == frame[i]);
+    }
+
+    uint8_t accepted = 0;
+    if(isLocal) {
+        accepted |= ERXFCON_UCEN;
+    }
+    if(isPatternMatch(frame, len)) {
+        accepted |= ERXFCON_PMEN;
+    }
+    if(isHashMatch(frame)) {
+        accepted |= ERXFCON_HTEN;
+    }
+    if(frame[0] & 0x01) {
+        accepted |= ERXFCON_MCEN;
+    }
+    if(isBroadcast) {
+        accepted |= ERXFCON_BCEN;
+    }
+
+    accepted &= enabled;
+    return (filters & ERXFCON_ANDOR) ? (accepted == enabled) :
+                                       (accepted != 0);
+}
+
+/**
+ * @brief Pattern match filter: checksum of bytes of window selected by
+ *        EPMM equals EPMCS, the window of 64 bytes from EPMO must be
+ *        inside the frame with its CRC
+ * @param [in] frame - pointer on frame without CRC
+ * @param [in] len - length of frame
+ */
+bool Enc28j60Sim::isPatternMatch(const uint8_t* frame, size_t len) const
+{
+    const size_t offset = _banks[1][EPMOL] | (_banks[1][EPMOH] << 8);
+    if((offset + PATTERN_WINDOW_SIZE) > (len + CRC_SIZE)) {
+        return false;
+    }
+
+    // the selected bytes are summed as one stream of big-endian words
+    uint32_t sum = 0;
+    bool isHigh = true;
+    for(size_t i = 0; i < PATTERN_WINDOW_SIZE; ++i) {
+        if(!(_banks[1][EPMM0 + i / 8] & (1 << (i % 8)))) {
+            continue;
+        }
+        // the window may cover the CRC, it is not compared in the model
+        const uint8_t octet = ((offset + i) < len) ? frame[offset + i] : 0;
+        sum += isHigh ? (octet << 8) : octet;
+        isHigh = !isHigh;
+    }
+    while(sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    sum = ~sum & 0xFFFF;
+    return ((sum >> 8) == _banks[1][EPMCSH]) &&
+           ((sum & 0xFF) == _banks[1][EPMCSL]);
+}
+
+/**
+ * @brief Hash table filter: bits 28:23 of CRC of destination address
+ *        (as shifted by MAC, most significant bit first) select the bit
+ *        of EHT0-EHT7
+ * @param [in] frame - pointer on frame
+ */
+bool Enc28j60Sim::isHashMatch(const uint8_t* frame) const
+{
+    // the reflected CRC holds the bits of MAC register in reverse order,
+    // the bit 23 + n of register is the bit 8 - n of reflected CRC
+    const uint32_t crc = ~crc32(frame, MAC_SIZE);
+    uint8_t pointer = 0;
+    for(size_t n = 0; n < 6; ++n) {
+        pointer |= ((crc >> (8 - n)) & 0x01) << n;
+    }
+    return (_banks[1][EHT0 + (pointer >> 3)] >> (pointer & 0x07)) & 0x01;
+}
+
+/**
+ * @brief Next address, it wraps from ERXND to ERXST
+ * @param [in] ptr - address
+ */
+uint16_t Enc28j60Sim::nextRx(uint16_t ptr)
+{
+    if(ptr == getPointer(ERXNDL)) {
+        return getPointer(ERXSTL);
+    }
+    return (ptr + 1) & (BUFFER_SIZE - 1);
+}
+
+/**
+ * @brief Update INT pin, the observer is called on its falling edge
+ */
+void Enc28j60Sim::updateInterrupt()
+{
+    const uint8_t eie = _banks[0][EIE];
+    const uint8_t eir = readRegister(EIR);
+    const bool isActive = (eie & EIE_INTIE) && (eie & eir & 0x7F);
+    if(isActive && !_isInterrupt && (_observer != nullptr)) {
+        _observer->update();
+    }
+    _isInterrupt = isActive;
+}
+
+/**
+ * @brief CRC of ethernet frame (IEEE 802.3)
+ * @param [in] data - pointer on frame
+ * @param [in] len - length of frame
+ */
+uint32_t Enc28j60Sim::crc32(const uint8_t* data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for(size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for(size_t bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 0x01) ? 0xEDB88320 : 0);
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,364 @@
+/**
+ ******************************************************************************
+ * @file    enc28j60_sim.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the behavioral model of ENC28J60 for host:
+ *          SPI operations, control registers and banks, PHY registers,
+ *          8 KB buffer memory with RX ring, packet counter, transmit and
+ *          DMA. Each SPI byte is counted for the cost model.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __ENC28J60_SIM_HPP
+#define __ENC28J60_SIM_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "ethernet/dma_interface.hpp"
+
+class SubjectObserver;
+
+/**
+ * @brief Class of ENC28J60 model. The collisions and the timing of MAC
+ *        are not modelled: the injected frames pass the receive filters
+ *        while RXEN is set (magic packet never matches), the transmit is
+ *        done on TXRTS.
+ */
+class Enc28j60Sim final
+    : private NonCopyable<Enc28j60Sim>
+    , private NonMovable<Enc28j60Sim> {
+  public:
+    /// Maximum ethernet frame without CRC
+    static constexpr size_t FRAME_SIZE = 1514;
+
+    /// Capacity of queue of transmitted frames
+    static constexpr size_t TX_QUEUE_SIZE = 16;
+
+    /// SPI traffic
+    struct Cost {
+        uint32_t bytes;    ///< Bytes on SPI (opcodes included)
+        uint32_t transactions;    ///< Assertions of chip select
+        uint32_t bankSwitches;    ///< Changes of bank bits of ECON1
+    };
+
+    Enc28j60Sim();
+
+    void select(bool);
+
+    bool isSelected() const;
+
+    uint8_t transfer(uint8_t);
+
+    void attach(SubjectObserver*);
+
+    bool inject(const uint8_t*, size_t);
+
+    size_t takeSent(uint8_t*, size_t);
+
+    void setLink(bool);
+
+    void setPrescaler(uint32_t);
+
+    const Cost& getCost() const;
+
+    void resetCost();
+
+    uint64_t estimateNs(uint32_t) const;
+
+    uint32_t getOverflows() const;
+
+    uint8_t getRegister(uint8_t, uint8_t) const;
+
+    uint16_t getPhy(uint8_t) const;
+
+  private:
+    /// SPI state after opcode
+    enum State {
+        STATE_IDLE,
+        STATE_OPCODE,
+        STATE_READ_REG,
+        STATE_READ_BUF,
+        STATE_WRITE_REG,
+        STATE_WRITE_BUF,
+        STATE_BIT_SET,
+        STATE_BIT_CLR,
+        STATE_DONE
+    };
+
+    /// Registers of model (address without bank)
+    enum Register : uint8_t {
+        ERDPTL = 0x00,
+        EWRPTL = 0x02,
+        ETXSTL = 0x04,
+        ETXNDL = 0x06,
+        ERXSTL = 0x08,
+        ERXSTH = 0x09,
+        ERXNDL = 0x0A,
+        ERXRDPTL = 0x0C,
+        ERXWRPTL = 0x0E,
+        EDMASTL = 0x10,
+        EDMANDL = 0x12,
+        EDMADSTL = 0x14,
+        EDMACSL = 0x16,
+        EDMACSH = 0x17,
+        EHT0 = 0x00,
+        EPMM0 = 0x08,
+        EPMCSL = 0x10,
+        EPMCSH = 0x11,
+        EPMOL = 0x14,
+        EPMOH = 0x15,
+        ERXFCON = 0x18,
+        EPKTCNT = 0x19,
+        MACON2 = 0x01,
+        MAMXFLL = 0x0A,
+        MAMXFLH = 0x0B,
+        MICMD = 0x12,
+        MIREGADR = 0x14,
+        MIWRL = 0x16,
+        MIWRH = 0x17,
+        MIRDL = 0x18,
+        MIRDH = 0x19,
+        MISTAT = 0x0A,
+        EREVID = 0x12,
+        EIE = 0x1B,
+        EIR = 0x1C,
+        ESTAT = 0x1D,
+        ECON2 = 0x1E,
+        ECON1 = 0x1F
+    };
+
+    enum Bits : uint8_t {
+        EIE_INTIE = 0x80,
+        EIR_PKTIF = 0x40,
+        EIR_DMAIF = 0x20,
+        EIR_TXIF = 0x08,
+        EIR_TXERIF = 0x02,
+        EIR_RXERIF = 0x01,
+        ESTAT_TXABRT = 0x02,
+        ESTAT_CLKRDY = 0x01,
+        ECON2_AUTOINC = 0x80,
+        ECON2_PKTDEC = 0x40,
+        ECON1_RXRST = 0x40,
+        ECON1_DMAST = 0x20,
+        ECON1_CSUMEN = 0x10,
+        ECON1_TXRTS = 0x08,
+        ECON1_RXEN = 0x04,
+        ECON1_BSEL = 0x03,
+        MICMD_MIIRD = 0x01,
+        ERXFCON_UCEN = 0x80,
+        ERXFCON_ANDOR = 0x40,
+        ERXFCON_PMEN = 0x10,
+        ERXFCON_MPEN = 0x08,
+        ERXFCON_HTEN = 0x04,
+        ERXFCON_MCEN = 0x02,
+        ERXFCON_BCEN = 0x01
+    };
+
+    enum PhyRegister : uint8_t {
+        PHCON1 = 0x00,
+        PHSTAT1 = 0x01,
+        PHHID1 = 0x02,
+        PHHID2 = 0x03,
+        PHSTAT2 = 0x11
+    };
+
+    enum Default {
+        BUFFER_SIZE = 0x2000,
+        BANKS = 4,
+        BANK_SIZE = 0x20,
+        COMMON_START = EIE,
+        PHY_SIZE = 0x20,
+        REVISION = 0x06,    ///< Rev. B7
+        MAX_FRAME_RESET = 0x0600,    ///< MAMXFL after reset
+        RX_HEADER_SIZE = 6,
+        CRC_SIZE = 4,
+        MAC_SIZE = 6,
+        PATTERN_WINDOW_SIZE = 64,
+        TX_STATUS_SIZE = 7
+    };
+
+    void reset();
+
+    uint8_t& reg(uint8_t);
+
+    uint16_t getPointer(uint8_t);
+
+    void setPointer(uint8_t, uint16_t);
+
+    size_t getMaxFrame() const;
+
+    bool isMacRegister(uint8_t) const;
+
+    uint8_t readRegister(uint8_t);
+
+    void writeRegister(uint8_t, uint8_t);
+
+    uint16_t readPhy(uint8_t) const;
+
+    bool isAccepted(const uint8_t*, size_t) const;
+
+    bool isPatternMatch(const uint8_t*, size_t) const;
+
+    bool isHashMatch(const uint8_t*) const;
+
+    void transmit();
+
+    void runDma();
+
+    uint16_t nextRx(uint16_t);
+
+    void updateInterrupt();
+
+    static uint32_t crc32(const uint8_t*, size_t);
+
+    uint8_t _banks[BANKS][BANK_SIZE];
+
+    uint16_t _phy[PHY_SIZE];
+
+    uint8_t _sram[BUFFER_SIZE];
+
+    State _state;
+
+    uint8_t _address;    ///< Register of current operation
+
+    bool _isDummy;    ///< Next read byte is dummy (MAC and MII registers)
+
+    bool _isLinkUp;
+
+    bool _isInterrupt;    ///< Level of INT pin (active)
+
+    SubjectObserver* _observer;
+
+    uint8_t _txFrames[TX_QUEUE_SIZE][FRAME_SIZE];
+
+    size_t _txLengths[TX_QUEUE_SIZE];
+
+    size_t _txHead;
+
+    size_t _txCount;
+
+    Cost _cost;
+
+    uint32_t _prescaler;    ///< Core cycles per SPI bit
+
+    uint32_t _overflows;    ///< Injected frames dropped on full ring
+};
+
+/**
+ * @brief Class of DMA channel of model, the transfer is done at once
+ *        through the same SPI model, or later by run() as on interrupt
+ *        (deferred mode). The bytes moved by DMA are counted, the rest
+ *        of SPI bytes is moved by CPU.
+ */
+class Enc28j60SimDma final
+    : private NonCopyable<Enc28j60SimDma>
+    , private NonMovable<Enc28j60SimDma>
+    , public DmaInterface {
+  public:
+    explicit Enc28j60SimDma(Enc28j60Sim* sim) :
+        _sim(sim),
+        _bytes(0),
+        _isDeferred(false),
+        _txData(nullptr),
+        _rxData(nullptr),
+        _len(0),
+        _busyPolls(0)
+    {
+    }
+
+    void startTransfer(const uint8_t* txData,
+        uint8_t* rxData,
+        size_t len) override
+    {
+        _txData = txData;
+        _rxData = rxData;
+        _len = len;
+        if(!_isDeferred) {
+            run();
+        }
+    }
+
+    bool isBusy() const override
+    {
+        ++_busyPolls;
+        return _len != 0;
+    }
+
+    /**
+     * @brief Transfer of started burst and its callback
+     * @retval true - burst was started
+     */
+    bool run()
+    {
+        if(0 == _len) {
+            return false;
+        }
+        _bytes += _len;
+        for(size_t i = 0; i < _len; ++i) {
+            const uint8_t data =
+                _sim->transfer((_txData != nullptr) ? _txData[i] : 0xFF);
+            if(_rxData != nullptr) {
+                _rxData[i] = data;
+            }
+        }
+        _len = 0;
+        complete();
+        return true;
+    }
+
+    /**
+     * @brief Mode of transfer
+     * @param [in] isDeferred - true - burst waits for run()
+     */
+    void setDeferred(bool isDeferred)
+    {
+        _isDeferred = isDeferred;
+    }
+
+    uint32_t getBusyPolls() const
+    {
+        return _busyPolls;
+    }
+
+    uint32_t getBytes() const
+    {
+        return _bytes;
+    }
+
+    void resetBytes()
+    {
+        _bytes = 0;
+    }
+
+  private:
+    Enc28j60Sim* const _sim;
+
+    uint32_t _bytes;    ///< Bytes of SPI moved by DMA
+
+    bool _isDeferred;    ///< Burst waits for run()
+
+    const uint8_t* _txData;    ///< Burst started and not done
+
+    uint8_t* _rxData;
+
+    size_t _len;
+
+    mutable uint32_t _busyPolls;    ///< Calls of isBusy()
+};
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ ******************************************************************************
+ * @file    loopback_device.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the in-memory network device for host:
+ *          the frames are injected for receive, the sent frames are
+ *          taken out or looped back.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "loopback_device.hpp"
+
+/**
+ * @brief Constructor
+ * @param [in] macAddr - MAC address of device
+ */
+LoopbackDevice::LoopbackDevice(const uint8_t* macAddr) : _dropped(0)
+{
+    _rxQueue.head = 0;
+    _rxQueue.count = 0;
+    _txQueue.head = 0;
+    _txQueue.count = 0;
+    memcpy(_macAddr, macAddr, MAC_ADDR_SIZE);
+}
+
+/**
+ * @brief Get the oldest injected frame, the whole frame is copied
+ * @param [out] frame - buffer of frame
+ * @param [in] maxLen - size of buffer, longer frame is truncated
+ * @retval length of frame, zero if queue is empty
+ */
+size_t LoopbackDevice::receive(uint8_t* frame, size_t maxLen)
+{
+    return pop(_rxQueue, frame, maxLen);
+}
+
+/**
+ * @brief Queue sent frame, the frame is dropped if queue is full
+ * @param [in] frame - pointer on frame
+ * @param [in] len - length of frame
+ */
+void LoopbackDevice::send(const uint8_t* frame, size_t len)
+{
+    push(_txQueue, frame, len);
+}
+
+bool LoopbackDevice::isLinkUp()
+{
+    return true;
+}
+
+const uint8_t* LoopbackDevice::getMacAddr() const
+{
+    return _macAddr;
+}
+
+/**
+ * @brief Queue frame for receive
+ * @param [in] frame - pointer on frame
+ * @param [in] len - length of frame
+ * @retval false if frame is dropped
+ */
+bool LoopbackDevice::inject(const uint8_t* frame, size_t len)
+{
+    return push(_rxQueue, frame, len);
+}
+
+/**
+ * @brief Get the oldest sent frame
+ * @param [out] frame - buffer of frame
+ * @param [in] maxLen - size of buffer, longer frame is truncated
+ * @retval length of frame, zero if there is no sent frame
+ */
+size_t LoopbackDevice::takeSent(uint8_t* frame, size_t maxLen)
+{
+    return pop(_txQueue, frame, maxLen);
+}
+
+/**
+ * @brief Move the sent frames into receive queue
+ * @retval number of moved frames
+ */
+size_t LoopbackDevice::loopback()
+{
+    size_t moved = 0;
+    while(_txQueue.count != 0) {
+        const size_t head = _txQueue.head;
+        push(_rxQueue, _txQueue.frames[head], _txQueue.lengths[head]);
+        _txQueue.head = (head + 1) % QUEUE_SIZE;
+        --_txQueue.count;
+        ++moved;
+    }
+    return moved;
+}
+
+size_t LoopbackDevice::getReceiveQueued() const
+{
+    return _rxQueue.count;
+}
+
+size_t LoopbackDevice::getSendQueued() const
+{
+    return _txQueue.count;
+}
+
+uint32_t LoopbackDevice::getDropped() const
+{
+    return _dropped;
+}
+
+bool LoopbackDevice::push(Queue& queue, const uint8_t* frame, size_t len)
+{
+    if((QUEUE_SIZE == queue.count) || (len > FRAME_SIZE)) {
+        ++_dropped;
+        return false;
+    }
+
+    const size_t tail = (queue.head + queue.count) % QUEUE_SIZE;
+    memcpy(queue.frames[tail], frame, len);
+    queue.lengths[tail] = len;
+    ++queue.count;
+    return true;
+}
+
+size_t LoopbackDevice::pop(Queue& queue, uint8_t* frame, size_t maxLen)
+{
+    if(0 == queue.count) {
+        return 0;
+    }
+
+    size_t len = queue.lengths[queue.head];
+    if(len > maxLen) {
+        len = maxLen;
+    }
+    memcpy(frame, queue.frames[queue.head], len);
+
+    queue.head = (queue.head + 1) % QUEUE_SIZE;
+    --queue.count;
+    return len;
+}
@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ * @file    loopback_device.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the in-memory network device for host:
+ *          the frames are injected for receive, the sent frames are
+ *          taken out or looped back.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LOOPBACK_DEVICE_HPP
+#define __LOOPBACK_DEVICE_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "ethernet/net_device.hpp"
+
+/**
+ * @brief Class of loopback device, the frames are queued in memory.
+ *        The sent frames are not received until loopback() so that
+ *        the replies of stack are not processed by the same poll.
+ */
+class LoopbackDevice final
+    : private NonCopyable<LoopbackDevice>
+    , private NonMovable<LoopbackDevice>
+    , public NetDevice {
+  public:
+    /// Maximum ethernet frame without CRC
+    static constexpr size_t FRAME_SIZE = 1514;
+
+    /// Capacity of queue of frames
+    static constexpr size_t QUEUE_SIZE = 16;
+
+    explicit LoopbackDevice(const uint8_t*);
+
+    size_t receive(uint8_t*, size_t) override;
+
+    void send(const uint8_t*, size_t) override;
+
+    bool isLinkUp() override;
+
+    const uint8_t* getMacAddr() const override;
+
+    bool inject(const uint8_t*, size_t);
+
+    size_t takeSent(uint8_t*, size_t);
+
+    size_t loopback();
+
+    size_t getReceiveQueued() const;
+
+    size_t getSendQueued() const;
+
+    uint32_t getDropped() const;
+
+  private:
+    /// Ring of frames
+    struct Queue {
+        uint8_t frames[QUEUE_SIZE][FRAME_SIZE];
+        size_t lengths[QUEUE_SIZE];
+        size_t head;    ///< Oldest frame
+        size_t count;    ///< Number of queued frames
+    };
+
+    LoopbackDevice() = delete;
+
+    bool push(Queue&, const uint8_t*, size_t);
+
+    static size_t pop(Queue&, uint8_t*, size_t);
+
+    Queue _rxQueue;    ///< Frames for receive
+
+    Queue _txQueue;    ///< Sent frames
+
+    uint32_t _dropped;    ///< Frames put into full queue
+
+    uint8_t _macAddr[MAC_ADDR_SIZE];
+};
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ ******************************************************************************
+ * @file    pcap_device.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the network device for host: the received
+ *          frames are replayed from pcap file, the sent frames are
+ *          recorded into pcap file.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "pcap_device.hpp"
+
+/**
+ * @brief Constructor
+ * @param [in] inputPath - pcap file of received frames, nullptr - no input
+ * @param [in] outputPath - pcap file of sent frames, nullptr - no output
+ * @param [in] macAddr - MAC address of device
+ */
+PcapDevice::PcapDevice(const char* inputPath,
+    const char* outputPath,
+    const uint8_t* macAddr) :
+    _input(nullptr),
+    _output(nullptr),
+    _isSwapped(false),
+    _isNano(false),
+    _seconds(0),
+    _micros(0),
+    _received(0),
+    _sent(0)
+{
+    memcpy(_macAddr, macAddr, MAC_ADDR_SIZE);
+
+    if(inputPath != nullptr) {
+        openInput(inputPath);
+    }
+    if(outputPath != nullptr) {
+        openOutput(outputPath);
+    }
+}
+
+PcapDevice::~PcapDevice()
+{
+    if(_input != nullptr) {
+        fclose(_input);
+    }
+    if(_output != nullptr) {
+        fclose(_output);
+    }
+}
+
+/**
+ * @brief Open pcap file and check its global header
+ * @param [in] path - path of file
+ * @retval false if file is not pcap of Ethernet frames
+ */
+bool PcapDevice::openInput(const char* path)
+{
+    _input = fopen(path, "rb");
+    if(nullptr == _input) {
+        return false;
+    }
+
+    uint8_t header[PCAP_GLOBAL_HEADER_SIZE];
+    if(fread(header, 1, sizeof(header), _input) != sizeof(header)) {
+        fclose(_input);
+        _input = nullptr;
+        return false;
+    }
+
+    // the magic number gives byte order and resolution of timestamps
+    const uint32_t magic = header[0] | (header[1] << 8) |
+                           (header[2] << 16) |
+                           (static_cast<uint32_t>(header[3]) << 24);
+    const uint32_t swappedMagic =
+        (static_cast<uint32_t>(header[0]) << 24) | (header[1] << 16) |
+        (header[2] << 8) | header[3];
+    _isSwapped = (PCAP_MAGIC == swappedMagic) ||
+                 (PCAP_MAGIC_NANO == swappedMagic);
+    const uint32_t nativeMagic = _isSwapped ? swappedMagic : magic;
+    _isNano = (PCAP_MAGIC_NANO == nativeMagic);
+
+    if(((nativeMagic != PCAP_MAGIC) && !_isNano) ||
+        (getWord(&header[20]) != PCAP_LINKTYPE_ETHERNET)) {
+        fclose(_input);
+        _input = nullptr;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Create pcap file and write its global header (little-endian)
+ * @param [in] path - path of file
+ * @retval false if file is not created
+ */
+bool PcapDevice::openOutput(const char* path)
+{
+    _output = fopen(path, "wb");
+    if(nullptr == _output) {
+        return false;
+    }
+
+    uint8_t header[PCAP_GLOBAL_HEADER_SIZE];
+    putWord(&header[0], PCAP_MAGIC);
+    header[4] = PCAP_VERSION_MAJOR;
+    header[5] = 0;
+    header[6] = PCAP_VERSION_MINOR;
+    header[7] = 0;
+    // time zone and accuracy of timestamps
+    putWord(&header[8], 0);
+    putWord(&header[12], 0);
+    putWord(&header[16], PCAP_SNAPLEN);
+    putWord(&header[20], PCAP_LINKTYPE_ETHERNET);
+    fwrite(header, 1, sizeof(header), _output);
+    return true;
+}
+
+/**
+ * @brief Read next frame of input file, the whole frame is copied
+ * @param [out] frame - buffer of frame
+ * @param [in] maxLen - size of buffer, longer frame is truncated
+ * @retval length of frame, zero at end of file
+ */
+size_t PcapDevice::receive(uint8_t* frame, size_t maxLen)
+{
+    if(nullptr == _input) {
+        return 0;
+    }
+
+    uint8_t header[PCAP_RECORD_HEADER_SIZE];
+    if(fread(header, 1, sizeof(header), _input) != sizeof(header)) {
+        return 0;
+    }
+    _seconds = getWord(&header[0]);
+    _micros = _isNano ? (getWord(&header[4]) / 1000) : getWord(&header[4]);
+    const size_t captured = getWord(&header[8]);
+
+    const size_t len = (captured > maxLen) ? maxLen : captured;
+    if(fread(frame, 1, len, _input) != len) {
+        return 0;
+    }
+    if(captured > len) {
+        fseek(_input, captured - len, SEEK_CUR);
+    }
+
+    ++_received;
+    return len;
+}
+
+/**
+ * @brief Write frame into output file, the timestamp is the timestamp of
+ *        last received frame (the replay is faster than real time)
+ * @param [in] frame - pointer on frame
+ * @param [in] len - length of frame
+ */
+void PcapDevice::send(const uint8_t* frame, size_t len)
+{
+    ++_sent;
+    if(nullptr == _output) {
+        return;
+    }
+
+    uint8_t header[PCAP_RECORD_HEADER_SIZE];
+    putWord(&header[0], _seconds);
+    putWord(&header[4], _micros);
+    putWord(&header[8], len);
+    putWord(&header[12], len);
+    fwrite(header, 1, sizeof(header), _output);
+    fwrite(frame, 1, len, _output);
+}
+
+/**
+ * @brief Link is up while there are frames for replay
+ */
+bool PcapDevice::isLinkUp()
+{
+    return (_input != nullptr) && !feof(_input);
+}
+
+const uint8_t* PcapDevice::getMacAddr() const
+{
+    return _macAddr;
+}
+
+bool PcapDevice::isOpen() const
+{
+    return (_input != nullptr) || (_output != nullptr);
+}
+
+uint32_t PcapDevice::getReceived() const
+{
+    return _received;
+}
+
+uint32_t PcapDevice::getSent() const
+{
+    return _sent;
+}
+
+/**
+ * @brief Get 32-bit word of input file
+ * @param [in] data - pointer on word
+ * @retval word in host order
+ */
+uint32_t PcapDevice::getWord(const uint8_t* data) const
+{
+    if(_isSwapped) {
+        return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) |
+               (data[2] << 8) | data[3];
+    }
+    return (static_cast<uint32_t>(data[3]) << 24) | (data[2] << 16) |
+           (data[1] << 8) | data[0];
+}
+
+/**
+ * @brief Put 32-bit little-endian word of output file
+ * @param [out] data - pointer on word
+ * @param [in] value - word
+ */
+void PcapDevice::putWord(uint8_t* data, uint32_t value)
+{
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = value >> 24;
+}
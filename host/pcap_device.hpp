@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ * @file    pcap_device.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the network device for host: the received
+ *          frames are replayed from pcap file, the sent frames are
+ *          recorded into pcap file.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PCAP_DEVICE_HPP
+#define __PCAP_DEVICE_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "ethernet/net_device.hpp"
+
+/**
+ * @brief Class of pcap device (link type Ethernet)
+ */
+class PcapDevice final
+    : private NonCopyable<PcapDevice>
+    , private NonMovable<PcapDevice>
+    , public NetDevice {
+  public:
+    PcapDevice(const char*, const char*, const uint8_t*);
+
+    ~PcapDevice();
+
+    size_t receive(uint8_t*, size_t) override;
+
+    void send(const uint8_t*, size_t) override;
+
+    bool isLinkUp() override;
+
+    const uint8_t* getMacAddr() const override;
+
+    bool isOpen() const;
+
+    uint32_t getReceived() const;
+
+    uint32_t getSent() const;
+
+  private:
+    /// Format of pcap file (see libpcap file format)
+    enum PcapFormat : uint32_t {
+        PCAP_MAGIC = 0xA1B2C3D4,    ///< timestamps in microseconds
+        PCAP_MAGIC_NANO = 0xA1B23C4D,    ///< timestamps in nanoseconds
+        PCAP_VERSION_MAJOR = 2,
+        PCAP_VERSION_MINOR = 4,
+        PCAP_SNAPLEN = 65535,
+        PCAP_LINKTYPE_ETHERNET = 1,
+        PCAP_GLOBAL_HEADER_SIZE = 24,
+        PCAP_RECORD_HEADER_SIZE = 16
+    };
+
+    PcapDevice() = delete;
+
+    bool openInput(const char*);
+
+    bool openOutput(const char*);
+
+    uint32_t getWord(const uint8_t*) const;
+
+    static void putWord(uint8_t*, uint32_t);
+
+    FILE* _input;    ///< Replayed frames, nullptr - no input
+
+    FILE* _output;    ///< Recorded frames, nullptr - no output
+
+    bool _isSwapped;    ///< Input is written in other byte order
+
+    bool _isNano;    ///< Timestamps of input in nanoseconds
+
+    uint32_t _seconds;    ///< Timestamp of last received frame
+
+    uint32_t _micros;
+
+    uint32_t _received;
+
+    uint32_t _sent;
+
+    uint8_t _macAddr[MAC_ADDR_SIZE];
+};
+
+#endif
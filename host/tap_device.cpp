@@ -0,0 +1,134 @@
+/**
+ ******************************************************************************
+ * @file    tap_device.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the network device for host: the frames are
+ *          exchanged with Linux kernel through TAP interface, so the stack
+ *          is tested against real TCP/IP stack (ping, curl).
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "tap_device.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+/**
+ * @brief Constructor, the interface is created if it does not exist
+ * @param [in] name - name of interface (e.g. "tap0")
+ * @param [in] macAddr - MAC address of device (not of interface)
+ */
+TapDevice::TapDevice(const char* name, const uint8_t* macAddr) :
+    _fd(-1),
+    _received(0),
+    _sent(0)
+{
+    memcpy(_macAddr, macAddr, MAC_ADDR_SIZE);
+
+    _fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+    if(_fd < 0) {
+        return;
+    }
+
+    // frames without packet information header
+    struct ifreq request;
+    memset(&request, 0, sizeof(request));
+    request.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(request.ifr_name, name, IFNAMSIZ - 1);
+    if(ioctl(_fd, TUNSETIFF, &request) < 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+TapDevice::~TapDevice()
+{
+    if(_fd >= 0) {
+        ::close(_fd);
+    }
+}
+
+/**
+ * @brief Read frame from interface, it does not block
+ * @param [out] frame - buffer of frame
+ * @param [in] maxLen - size of buffer, longer frame is truncated
+ * @retval length of frame, zero if there is not frame
+ */
+size_t TapDevice::receive(uint8_t* frame, size_t maxLen)
+{
+    if(_fd < 0) {
+        return 0;
+    }
+    const ssize_t len = read(_fd, frame, maxLen);
+    if(len <= 0) {
+        return 0;
+    }
+    ++_received;
+    return len;
+}
+
+/**
+ * @brief Write frame into interface
+ * @param [in] frame - pointer on frame
+ * @param [in] len - length of frame
+ */
+void TapDevice::send(const uint8_t* frame, size_t len)
+{
+    if((_fd >= 0) && (write(_fd, frame, len) > 0)) {
+        ++_sent;
+    }
+}
+
+bool TapDevice::isLinkUp()
+{
+    return _fd >= 0;
+}
+
+const uint8_t* TapDevice::getMacAddr() const
+{
+    return _macAddr;
+}
+
+bool TapDevice::isOpen() const
+{
+    return _fd >= 0;
+}
+
+/**
+ * @brief Wait for received frame
+ * @param [in] timeoutMs - timeout in milliseconds, negative - infinite
+ * @retval true - frame is ready
+ */
+bool TapDevice::wait(int timeoutMs)
+{
+    if(_fd < 0) {
+        return false;
+    }
+    struct pollfd descriptor;
+    descriptor.fd = _fd;
+    descriptor.events = POLLIN;
+    descriptor.revents = 0;
+    return poll(&descriptor, 1, timeoutMs) > 0;
+}
+
+uint32_t TapDevice::getReceived() const
+{
+    return _received;
+}
+
+uint32_t TapDevice::getSent() const
+{
+    return _sent;
+}
@@ -0,0 +1,75 @@
+/**
+ ******************************************************************************
+ * @file    tap_device.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the network device for host: the frames are
+ *          exchanged with Linux kernel through TAP interface, so the stack
+ *          is tested against real TCP/IP stack (ping, curl).
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TAP_DEVICE_HPP
+#define __TAP_DEVICE_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Utils */
+#include "utils/non_copyable.hpp"
+#include "utils/non_movable.hpp"
+
+#include "ethernet/net_device.hpp"
+
+/**
+ * @brief Class of TAP device (Linux only, needs access to /dev/net/tun).
+ *        The interface is brought up and addressed by user, e.g.
+ *        "ip addr add 192.168.0.1/24 dev tap0; ip link set tap0 up".
+ */
+class TapDevice final
+    : private NonCopyable<TapDevice>
+    , private NonMovable<TapDevice>
+    , public NetDevice {
+  public:
+    TapDevice(const char*, const uint8_t*);
+
+    ~TapDevice();
+
+    size_t receive(uint8_t*, size_t) override;
+
+    void send(const uint8_t*, size_t) override;
+
+    bool isLinkUp() override;
+
+    const uint8_t* getMacAddr() const override;
+
+    bool isOpen() const;
+
+    bool wait(int);
+
+    uint32_t getReceived() const;
+
+    uint32_t getSent() const;
+
+  private:
+    TapDevice() = delete;
+
+    int _fd;    ///< Descriptor of interface, negative - not open
+
+    uint32_t _received;
+
+    uint32_t _sent;
+
+    uint8_t _macAddr[MAC_ADDR_SIZE];
+};
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ ******************************************************************************
+ * @file    test_devices.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the test of network devices of host:
+ *          loopback device under protocol stack, record and replay
+ *          of pcap device, TAP device (skipped without /dev/net/tun).
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+#include "loopback_device.hpp"
+#include "pcap_device.hpp"
+#include "tap_device.hpp"
+
+#include <unistd.h>
+
+namespace {
+    constexpr size_t FRAMES = 8;
+
+    uint8_t request[Test::MAX_FRAME_SIZE];
+
+    uint8_t reply[Test::MAX_FRAME_SIZE];
+
+    /**
+     * @brief Stack answers over loopback device, the full queue drops
+     */
+    void testLoopback()
+    {
+        static LoopbackDevice device(Test::BOARD_MAC);
+        static StaticPacketPool<> pool;
+        NetStack::Config config;
+        config.ipAddr = Test::BOARD_IP;
+        NetStack stack(&device, &pool, &config);
+
+        for(size_t i = 0; i < FRAMES; ++i) {
+            const size_t len = Test::makeEchoRequest(request, 100 * i, i);
+            CHECK(device.inject(request, len));
+        }
+        CHECK(FRAMES == device.getReceiveQueued());
+        for(size_t i = 0; i < FRAMES; ++i) {
+            stack.poll();
+        }
+        CHECK(0 == device.getReceiveQueued());
+        CHECK(FRAMES == device.getSendQueued());
+        for(size_t i = 0; i < FRAMES; ++i) {
+            const size_t len = device.takeSent(reply, sizeof(reply));
+            CHECK((Ethernet::TRANSPORT_P + 8 + 100 * i) == len);
+            CHECK(Ethernet::IcmpHeader::TYPE_ECHO_REPLY ==
+                  reply[Ethernet::TRANSPORT_P]);
+        }
+
+        // the sent frames come back as received ones
+        const size_t len = Test::makeArpRequest(request);
+        device.send(request, len);
+        CHECK(1 == device.loopback());
+        CHECK(device.receive(reply, sizeof(reply)) == len);
+        CHECK(0 == memcmp(request, reply, len));
+
+        for(size_t i = 0; i < LoopbackDevice::QUEUE_SIZE; ++i) {
+            CHECK(device.inject(request, len));
+        }
+        CHECK(!device.inject(request, len));
+        CHECK(1 == device.getDropped());
+    }
+
+    /**
+     * @brief Sent frames are recorded into pcap file, the file is replayed
+     */
+    void testPcap()
+    {
+        char path[] = "/tmp/test_devices_XXXXXX";
+        const int fd = mkstemp(path);
+        CHECK(fd >= 0);
+        if(fd < 0) {
+            return;
+        }
+        close(fd);
+
+        size_t lengths[FRAMES];
+        {
+            PcapDevice output(nullptr, path, Test::BOARD_MAC);
+            CHECK(output.isOpen());
+            for(size_t i = 0; i < FRAMES; ++i) {
+                lengths[i] = Test::makeEchoRequest(request, 200 * i, i);
+                output.send(request, lengths[i]);
+            }
+            CHECK(FRAMES == output.getSent());
+        }
+
+        PcapDevice input(path, nullptr, Test::BOARD_MAC);
+        CHECK(input.isOpen());
+        for(size_t i = 0; i < FRAMES; ++i) {
+            CHECK(input.isLinkUp());
+            Test::makeEchoRequest(request, 200 * i, i);
+            CHECK(input.receive(reply, sizeof(reply)) == lengths[i]);
+            CHECK(0 == memcmp(request, reply, lengths[i]));
+        }
+        CHECK(0 == input.receive(reply, sizeof(reply)));
+        CHECK(!input.isLinkUp());
+        CHECK(FRAMES == input.getReceived());
+        unlink(path);
+    }
+
+    /**
+     * @brief TAP interface is created, nothing is received while
+     *        the interface is down
+     * @retval false - TAP device is not permitted (test is skipped)
+     */
+    bool testTap()
+    {
+        TapDevice device("enctest0", Test::BOARD_MAC);
+        if(!device.isOpen()) {
+            printf("test_tap: skipped, no access to /dev/net/tun\n");
+            return false;
+        }
+        CHECK(device.isLinkUp());
+        CHECK(!device.wait(10));
+        CHECK(0 == device.receive(reply, sizeof(reply)));
+        CHECK(0 == device.getReceived());
+        return true;
+    }
+}
+
+/**
+ * @brief Test of loopback and pcap devices, or of TAP device
+ *        with argument "tap" (it needs access to /dev/net/tun)
+ */
+int main(int argc, char** argv)
+{
+    if((argc > 1) && (0 == strcmp(argv[1], "tap"))) {
+        return testTap() ? Test::getResult("test_tap") : Test::SKIPPED;
+    }
+
+    testLoopback();
+    testPcap();
+    return Test::getResult("test_devices");
+}
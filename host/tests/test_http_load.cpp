@@ -0,0 +1,300 @@
+/**
+ ******************************************************************************
+ * @file    test_http_load.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the load test of HTTP server over ENC28J60
+ *          model: the peer opens connection, requests a page, acknowledges
+ *          the response and closes, one request after another. Requests
+ *          per second are reported of host CPU and of SPI time of board.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+#include "ethernet/http_server.hpp"
+
+#include <chrono>
+
+#define PAGE_LINE "0123456789abcdefghijklmnopqrstuvwxyz\r\n"
+#define PAGE_LINES_8                                                       \
+    PAGE_LINE PAGE_LINE PAGE_LINE PAGE_LINE PAGE_LINE PAGE_LINE PAGE_LINE \
+        PAGE_LINE
+
+namespace {
+    /// Core clock of board for estimate of SPI time
+    constexpr uint32_t CORE_CLOCK = 72000000;
+
+    /// Prescaler of SPI selected by calibration on board
+    constexpr uint32_t PRESCALER = 4;
+
+    constexpr uint16_t HTTP_PORT = 80;
+
+    constexpr uint16_t FIRST_PEER_PORT = 40000;
+
+    constexpr size_t REQUESTS = 500;
+
+    /// Window of peer, the response of several segments is in flight
+    constexpr uint16_t PEER_WINDOW = 8192;
+
+    /// Time of model between polls of board
+    constexpr uint32_t TICK_MS = 1;
+
+    /// Exchanges of one response, more means that the transfer is stuck
+    constexpr size_t MAX_EXCHANGES = 64;
+
+    constexpr size_t MAX_REQUEST_LEN = 64;
+
+    constexpr auto STATUS_PAGE = makeHttpResponse("200 OK",
+        "text/html",
+        "<html><head><title>Ethernet</title></head><body>"
+        "<h1>STM32F10x + ENC28J60</h1><p>Online</p></body></html>\n");
+
+    constexpr auto BIG_PAGE = makeHttpResponse("200 OK",
+        "text/plain",
+        PAGE_LINES_8 PAGE_LINES_8 PAGE_LINES_8 PAGE_LINES_8 PAGE_LINES_8
+            PAGE_LINES_8 PAGE_LINES_8 PAGE_LINES_8);
+
+    constexpr HttpResource RESOURCES[] = { { "/", STATUS_PAGE },
+        { "/big", BIG_PAGE } };
+
+    uint8_t request[Test::MAX_FRAME_SIZE];
+
+    uint8_t reply[Test::MAX_FRAME_SIZE];
+
+    /// Received response of one request
+    uint8_t response[BIG_PAGE.SIZE];
+
+    /**
+     * @brief Peer of board: TCP client of one connection at a time
+     */
+    class Peer {
+      public:
+        Peer(Test::SimBoard* board, HttpServer* http) :
+            _board(board),
+            _http(http),
+            _now(0),
+            _port(FIRST_PEER_PORT),
+            _sequence(0),
+            _acknowledge(0),
+            _flags(0),
+            _responseLen(0)
+        {
+        }
+
+        /**
+         * @brief Request of page through new connection
+         * @param [in] resource - resource of page
+         * @retval true - the whole response is received, the connection
+         *         is closed by both sides
+         */
+        bool get(const HttpResource& resource)
+        {
+            using Ethernet::TcpHeader;
+            ++_port;
+            _sequence = _port * 1000;
+            _responseLen = 0;
+
+            send(TcpHeader::FLAG_SYN, nullptr, 0);
+            ++_sequence;
+            if(!exchange() ||
+                !(TcpHeader::FLAG_SYN & _flags) ||
+                !(TcpHeader::FLAG_ACK & _flags)) {
+                return false;
+            }
+
+            char line[MAX_REQUEST_LEN];
+            const int len = snprintf(line,
+                sizeof(line),
+                "GET %s HTTP/1.1\r\nHost: board\r\n\r\n",
+                resource.path);
+            send(TcpHeader::FLAG_ACK | TcpHeader::FLAG_PUSH,
+                reinterpret_cast<const uint8_t*>(line),
+                len);
+            _sequence += len;
+
+            // the response is acknowledged until FIN of board
+            for(size_t i = 0; i < MAX_EXCHANGES; ++i) {
+                if(!exchange()) {
+                    return false;
+                }
+                if(TcpHeader::FLAG_FIN & _flags) {
+                    send(TcpHeader::FLAG_ACK | TcpHeader::FLAG_FIN,
+                        nullptr,
+                        0);
+                    ++_sequence;
+                    // the last ACK of board, then TIME_WAIT
+                    return exchange() && (_responseLen == resource.size) &&
+                           (0 == memcmp(response,
+                                     resource.response,
+                                     resource.size));
+                }
+                send(TcpHeader::FLAG_ACK, nullptr, 0);
+            }
+            return false;
+        }
+
+      private:
+        /**
+         * @brief Segment of peer to board
+         * @param [in] flags - flags of TCP header
+         * @param [in] data - pointer on data, nullptr - without data
+         * @param [in] len - length of data
+         */
+        void send(uint8_t flags, const uint8_t* data, size_t len)
+        {
+            using namespace Ethernet;
+            const size_t tcpLen = TcpHeader::SIZE + len;
+            MakeIpFrame(request,
+                Test::BOARD_MAC,
+                Test::PEER_MAC,
+                Test::BOARD_IP,
+                Test::PEER_IP,
+                IpHeader::PROTOCOL_TCP,
+                IpHeader::SIZE + tcpLen,
+                static_cast<uint16_t>(_sequence));
+
+            TcpHeader tcp(&request[TRANSPORT_P]);
+            tcp.setSrcPort(_port);
+            tcp.setDstPort(HTTP_PORT);
+            tcp.setSequence(_sequence);
+            tcp.setAcknowledge(_acknowledge);
+            tcp.setHeaderLen(TcpHeader::SIZE);
+            tcp.setFlags(flags);
+            tcp.setWindow(PEER_WINDOW);
+            tcp.setChecksum(0);
+            tcp.setUrgentPtr(0);
+            if(len > 0) {
+                memcpy(&request[TRANSPORT_P + TcpHeader::SIZE], data, len);
+            }
+            tcp.setChecksum(
+                CalcTransportChecksum(request, tcpLen, PacketType_t::TCP));
+            CHECK(_board->getSim().inject(request, TRANSPORT_P + tcpLen));
+        }
+
+        /**
+         * @brief Board is polled, its segments are taken: the data is
+         *        appended to response, the flags are collected
+         * @retval true - board has sent at least one segment
+         */
+        bool exchange()
+        {
+            using namespace Ethernet;
+            _now += TICK_MS;
+            _board->getStack().poll();
+            _http->tick(_now);
+
+            _flags = 0;
+            bool isReceived = false;
+            size_t len = 0;
+            while((len = _board->getSim().takeSent(reply, sizeof(reply))) !=
+                  0) {
+                const TcpHeader tcp(&reply[TRANSPORT_P]);
+                const IpHeader ip(&reply[IP_P]);
+                if((len < (TRANSPORT_P + TcpHeader::SIZE)) ||
+                    (tcp.getDstPort() != _port)) {
+                    continue;
+                }
+                isReceived = true;
+                _flags |= tcp.getFlags();
+
+                const size_t dataLen =
+                    ip.getTotalLen() - IpHeader::SIZE - tcp.getHeaderLen();
+                const uint8_t* data =
+                    &reply[TRANSPORT_P + tcp.getHeaderLen()];
+                if(TcpHeader::FLAG_SYN & tcp.getFlags()) {
+                    _acknowledge = tcp.getSequence() + 1;
+                }
+                else if(tcp.getSequence() == _acknowledge) {
+                    if((dataLen > 0) &&
+                        ((_responseLen + dataLen) <= sizeof(response))) {
+                        memcpy(&response[_responseLen], data, dataLen);
+                        _responseLen += dataLen;
+                    }
+                    _acknowledge += dataLen;
+                    if(TcpHeader::FLAG_FIN & tcp.getFlags()) {
+                        ++_acknowledge;
+                    }
+                }
+            }
+            return isReceived;
+        }
+
+        Test::SimBoard* const _board;
+
+        HttpServer* const _http;
+
+        uint32_t _now;    ///< Time of model, milliseconds
+
+        uint16_t _port;    ///< Port of current connection
+
+        uint32_t _sequence;    ///< Next sequence number of peer
+
+        uint32_t _acknowledge;    ///< Next expected sequence of board
+
+        uint8_t _flags;    ///< Flags of segments of last exchange
+
+        size_t _responseLen;
+    };
+
+    /**
+     * @brief Requests of one page one after another
+     * @param [in] name - name of page for report
+     */
+    void testLoad(Test::SimBoard& board,
+        HttpServer& http,
+        const HttpResource& resource,
+        const char* name)
+    {
+        Peer peer(&board, &http);
+        Enc28j60Sim& sim = board.getSim();
+        sim.resetCost();
+        http.resetStatistics();
+
+        size_t passed = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < REQUESTS; ++i) {
+            if(peer.get(resource)) {
+                ++passed;
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+        CHECK(REQUESTS == passed);
+        CHECK(REQUESTS == http.getStatistics().requests);
+        CHECK(0 == board.getPool().getStatistics().used);
+
+        const double hostSeconds =
+            std::chrono::duration<double>(end - start).count();
+        sim.setPrescaler(PRESCALER);
+        const double spiSeconds = sim.estimateNs(CORE_CLOCK) * 1e-9;
+        printf("test_http_load: %s (%zu bytes) %zu requests, "
+               "%.0f requests/s of host, %.0f requests/s of SPI "
+               "at %u MHz / %u\n",
+            name,
+            resource.size,
+            passed,
+            passed / hostSeconds,
+            passed / spiSeconds,
+            static_cast<unsigned>(CORE_CLOCK / 1000000),
+            static_cast<unsigned>(PRESCALER));
+    }
+}
+
+int main()
+{
+    static Test::SimBoard board(true, true, HTTP_PORT);
+    static HttpServer http(&board.getStack(),
+        RESOURCES,
+        sizeof(RESOURCES) / sizeof(RESOURCES[0]));
+    CHECK(http.listen());
+
+    testLoad(board, http, RESOURCES[0], "status page");
+    testLoad(board, http, RESOURCES[1], "big page");
+    return Test::getResult("test_http_load");
+}
@@ -0,0 +1,142 @@
+/**
+ ******************************************************************************
+ * @file    test_instrumentation.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the test of per-frame counters of build
+ *          with ENC28J60_INSTRUMENTATION: ARP, ICMP and corrupted frames
+ *          are counted by their types, the SPI counters of each frame
+ *          match the traffic seen by ENC28J60 model.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+
+namespace {
+    constexpr size_t ECHO_DATA = 100;
+
+    uint8_t request[Test::MAX_FRAME_SIZE];
+
+    uint8_t reply[Test::MAX_FRAME_SIZE];
+
+    /**
+     * @brief Board of one frame per poll: the counters of frame cover
+     *        the whole poll, as the cost of model does
+     */
+    class Board {
+      public:
+        Board() :
+            _interface{ &_sim },
+            _net(&_interface, getDeviceConfig()),
+            _stack(&_net, &_pool, getStackConfig())
+        {
+        }
+
+        /**
+         * @brief Frame is injected and processed by one poll
+         * @param [in] type - expected type of frame
+         * @param [in] len - length of frame
+         * @param [in] isAnswered - board sends reply
+         * @param [in] name - name of frame for report
+         */
+        void check(Instrumentation::FrameType type,
+            size_t len,
+            bool isAnswered,
+            const char* name)
+        {
+            const Instrumentation before = _net.getInstrumentation();
+            CHECK(_sim.inject(request, len));
+            _sim.resetCost();
+            CHECK(1 == _stack.poll());
+            CHECK(isAnswered == (_sim.takeSent(reply, sizeof(reply)) != 0));
+
+            const Instrumentation& after = _net.getInstrumentation();
+            const Enc28j60Sim::Cost& cost = _sim.getCost();
+            for(size_t i = 0; i < Instrumentation::FRAME_TYPES; ++i) {
+                const Instrumentation::Counters& from = before.frame[i];
+                const Instrumentation::Counters& to = after.frame[i];
+                if(i != type) {
+                    CHECK(0 == memcmp(&from, &to, sizeof(to)));
+                    continue;
+                }
+                CHECK((from.frames + 1) == to.frames);
+                CHECK((from.bytes + len) == to.bytes);
+                CHECK((from.spiTransactions + cost.transactions) ==
+                      to.spiTransactions);
+                CHECK((from.bankSwitches + cost.bankSwitches) ==
+                      to.bankSwitches);
+            }
+            printf("test_instrumentation: %s %u transactions, "
+                   "%u bank switches\n",
+                name,
+                static_cast<unsigned>(cost.transactions),
+                static_cast<unsigned>(cost.bankSwitches));
+        }
+
+      private:
+        const Enc28j60::Config* getDeviceConfig()
+        {
+            memcpy(_deviceConfig.macAddr,
+                Test::BOARD_MAC,
+                NetDevice::MAC_ADDR_SIZE);
+            return &_deviceConfig;
+        }
+
+        const NetStack::Config* getStackConfig()
+        {
+            _stackConfig.ipAddr = Test::BOARD_IP;
+            _stackConfig.pollBudget = 1;
+            return &_stackConfig;
+        }
+
+        Enc28j60Sim _sim;
+
+        SpiInterface::Config _interface;
+
+        Enc28j60::Config _deviceConfig;
+
+        Enc28j60 _net;
+
+        StaticPacketPool<> _pool;
+
+        NetStack::Config _stackConfig;
+
+        NetStack _stack;
+    };
+}
+
+int main()
+{
+    static Board board;
+
+    board.check(Instrumentation::FRAME_ARP,
+        Test::makeArpRequest(request),
+        true,
+        "ARP");
+    board.check(Instrumentation::FRAME_ICMP,
+        Test::makeEchoRequest(request, ECHO_DATA, 1),
+        true,
+        "ICMP");
+
+    // the IP header and the echo data are corrupted
+    size_t len = Test::makeEchoRequest(request, ECHO_DATA, 2);
+    request[Ethernet::IP_P + Ethernet::IpHeader::TTL] ^= 0x01;
+    board.check(Instrumentation::FRAME_DROPPED, len, false, "bad IP");
+    len = Test::makeEchoRequest(request, ECHO_DATA, 3);
+    request[len - 1] ^= 0x01;
+    board.check(Instrumentation::FRAME_DROPPED, len, false, "bad ICMP");
+
+    // the frame of other host is not processed
+    len = Test::makeEchoRequest(request, ECHO_DATA, 4);
+    Ethernet::IpHeader(&request[Ethernet::IP_P]).setDstIp(Test::PEER_IP);
+    board.check(Instrumentation::FRAME_OTHER, len, false, "other host");
+
+    return Test::getResult("test_instrumentation");
+}
@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ * @file    test_offload.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the test of checksum check of received
+ *          frames: the offload of ENC28J60 model and software check
+ *          of fetched frame give the same results.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+
+namespace {
+    constexpr size_t ROUNDS = 200;
+
+    uint8_t request[Test::MAX_FRAME_SIZE];
+
+    uint8_t offloadFrame[Test::MAX_FRAME_SIZE];
+
+    uint8_t softwareFrame[Test::MAX_FRAME_SIZE];
+
+    /**
+     * @brief Check of IP header and ICMP message of received frame
+     * @param [out] frame - buffer of frame
+     * @param [in] len - length of injected frame
+     * @param [out] isValidIp - checksum of IP header is valid
+     * @retval true - checksum of ICMP message is valid
+     */
+    bool check(Test::SimBoard& board,
+        uint8_t* frame,
+        size_t len,
+        bool* isValidIp)
+    {
+        Enc28j60& device = board.getDevice();
+        CHECK(device.receive(frame, Test::MAX_FRAME_SIZE) == len);
+        *isValidIp = device.isValidChecksum(
+            frame, Ethernet::IP_P, Ethernet::IpHeader::SIZE);
+        return device.isValidChecksum(
+            frame, Ethernet::TRANSPORT_P, len - Ethernet::TRANSPORT_P);
+    }
+
+    /**
+     * @brief Echo requests of random length, some of them have one
+     *        corrupted byte (also out of head of frame), are checked
+     *        by both boards
+     */
+    void testEquivalence(Test::SimBoard& offload, Test::SimBoard& software)
+    {
+        Test::Random random;
+        size_t invalid = 0;
+        for(size_t round = 0; round < ROUNDS; ++round) {
+            const size_t dataLen = random.next() % (Test::MAX_ECHO_DATA + 1);
+            const size_t len = Test::makeEchoRequest(request, dataLen, round);
+            const bool isCorrupted = (round % 3) == 0;
+            if(isCorrupted) {
+                const size_t pos = Ethernet::IP_P +
+                                   random.next() % (len - Ethernet::IP_P);
+                request[pos] ^= static_cast<uint8_t>(
+                    1 + random.next() % 0xFF);
+            }
+            CHECK(offload.getSim().inject(request, len));
+            CHECK(software.getSim().inject(request, len));
+
+            bool isOffloadIp = false;
+            bool isSoftwareIp = false;
+            const bool isOffload =
+                check(offload, offloadFrame, len, &isOffloadIp);
+            const bool isSoftware =
+                check(software, softwareFrame, len, &isSoftwareIp);
+            CHECK(isOffloadIp == isSoftwareIp);
+            CHECK(isOffload == isSoftware);
+            CHECK(isCorrupted != (isOffloadIp && isOffload));
+            if(!isOffloadIp || !isOffload) {
+                ++invalid;
+            }
+        }
+        printf("test_offload: %zu frames, %zu invalid\n", ROUNDS, invalid);
+    }
+
+    /**
+     * @brief Corrupted data out of head is not answered by stack
+     *        in both modes
+     */
+    void testEcho(Test::SimBoard& board)
+    {
+        Enc28j60Sim& sim = board.getSim();
+        const size_t len =
+            Test::makeEchoRequest(request, Test::MAX_ECHO_DATA, 0);
+        request[len - 1] ^= 0x01;
+        CHECK(sim.inject(request, len));
+        board.getStack().poll();
+        CHECK(0 == sim.takeSent(offloadFrame, sizeof(offloadFrame)));
+
+        request[len - 1] ^= 0x01;
+        CHECK(sim.inject(request, len));
+        board.getStack().poll();
+        CHECK(sim.takeSent(offloadFrame, sizeof(offloadFrame)) == len);
+    }
+}
+
+int main()
+{
+    static Test::SimBoard offload(false, true);
+    static Test::SimBoard software(false, false);
+    testEquivalence(offload, software);
+    testEcho(offload);
+    testEcho(software);
+    return Test::getResult("test_offload");
+}
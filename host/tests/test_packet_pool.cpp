@@ -0,0 +1,156 @@
+/**
+ ******************************************************************************
+ * @file    test_packet_pool.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the test of pool of frame buffers: owners
+ *          of buffers, occupancy counters and headroom of packets.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+
+namespace {
+    /**
+     * @brief The allocation on empty pool fails and is counted, the high
+     *        water stays on maximum after release
+     */
+    void testAllocate()
+    {
+        static StaticPacketPool<> pool;
+        PacketBuffer* buffers[PacketPool::BUFFER_COUNT];
+        CHECK(PacketPool::BUFFER_COUNT == pool.getStatistics().capacity);
+
+        for(size_t i = 0; i < PacketPool::BUFFER_COUNT; ++i) {
+            buffers[i] = pool.allocate();
+            CHECK(buffers[i] != nullptr);
+            CHECK(1 == buffers[i]->refCount);
+            CHECK(PacketPool::HEADROOM == buffers[i]->headroom());
+            CHECK(0 == buffers[i]->len);
+        }
+        CHECK(nullptr == pool.allocate());
+        CHECK(nullptr == pool.allocate(0));
+
+        const PacketPool::Statistics& statistics = pool.getStatistics();
+        CHECK(PacketPool::BUFFER_COUNT == statistics.used);
+        CHECK(PacketPool::BUFFER_COUNT == statistics.highWater);
+        CHECK(PacketPool::BUFFER_COUNT == statistics.allocations);
+        CHECK(2 == statistics.failures);
+
+        pool.release(buffers[0]);
+        pool.release(buffers[1]);
+        CHECK(0 == buffers[0]->refCount);
+        CHECK((PacketPool::BUFFER_COUNT - 2) == statistics.used);
+        CHECK(PacketPool::BUFFER_COUNT == statistics.highWater);
+
+        // the headroom is not larger than buffer
+        CHECK(nullptr == pool.allocate(PacketBuffer::SIZE + 1));
+        CHECK(3 == statistics.failures);
+
+        // the counters are cleared, the occupancy is kept
+        pool.resetStatistics();
+        CHECK((PacketPool::BUFFER_COUNT - 2) == statistics.used);
+        CHECK(statistics.used == statistics.highWater);
+        CHECK(0 == statistics.allocations);
+        CHECK(0 == statistics.failures);
+
+        for(size_t i = 2; i < PacketPool::BUFFER_COUNT; ++i) {
+            pool.release(buffers[i]);
+        }
+        CHECK(0 == statistics.used);
+    }
+
+    /**
+     * @brief The second release of buffer and release of nullptr do not
+     *        change the pool, the buffer is given out once
+     */
+    void testRelease()
+    {
+        static StaticPacketPool<> pool;
+        PacketBuffer* buffer = pool.allocate();
+        CHECK(buffer != nullptr);
+        pool.release(buffer);
+        pool.release(buffer);
+        pool.release(nullptr);
+        CHECK(0 == buffer->refCount);
+        CHECK(0 == pool.getStatistics().used);
+
+        PacketBuffer* buffers[PacketPool::BUFFER_COUNT];
+        for(size_t i = 0; i < PacketPool::BUFFER_COUNT; ++i) {
+            buffers[i] = pool.allocate();
+            CHECK(buffers[i] != nullptr);
+            for(size_t j = 0; j < i; ++j) {
+                CHECK(buffers[i] != buffers[j]);
+            }
+        }
+        CHECK(nullptr == pool.allocate());
+        CHECK(PacketPool::BUFFER_COUNT == pool.getStatistics().used);
+        for(size_t i = 0; i < PacketPool::BUFFER_COUNT; ++i) {
+            pool.release(buffers[i]);
+        }
+    }
+
+    /**
+     * @brief The number of buffers is set by template of pool
+     */
+    void testCapacity()
+    {
+        constexpr size_t BUFFERS = PacketPool::BUFFER_COUNT + 2;
+        static StaticPacketPool<BUFFERS> pool;
+        CHECK(BUFFERS == pool.getStatistics().capacity);
+
+        PacketBuffer* buffers[BUFFERS];
+        for(size_t i = 0; i < BUFFERS; ++i) {
+            buffers[i] = pool.allocate();
+            CHECK(buffers[i] != nullptr);
+        }
+        CHECK(nullptr == pool.allocate());
+        CHECK(BUFFERS == pool.getStatistics().highWater);
+        for(size_t i = 0; i < BUFFERS; ++i) {
+            pool.release(buffers[i]);
+        }
+        CHECK(0 == pool.getStatistics().used);
+    }
+
+    /**
+     * @brief The headers are added into headroom and removed in place
+     */
+    void testHeadroom()
+    {
+        static StaticPacketPool<> pool;
+        PacketBuffer* buffer = pool.allocate(Ethernet::TRANSPORT_P);
+        CHECK(buffer != nullptr);
+        uint8_t* const payload = buffer->payload();
+        buffer->len = 10;
+        CHECK((PacketBuffer::SIZE - Ethernet::TRANSPORT_P - 10) ==
+              buffer->tailroom());
+
+        CHECK(nullptr == buffer->prepend(Ethernet::TRANSPORT_P + 1));
+        CHECK((payload - Ethernet::IP_P) == buffer->prepend(Ethernet::IP_P));
+        CHECK((10 + Ethernet::IP_P) == buffer->len);
+        CHECK(&buffer->data[0] ==
+              buffer->prepend(Ethernet::IpHeader::SIZE));
+        CHECK(0 == buffer->headroom());
+
+        CHECK(nullptr == buffer->strip(buffer->len + 1));
+        CHECK(payload == buffer->strip(Ethernet::TRANSPORT_P));
+        CHECK(10 == buffer->len);
+        pool.release(buffer);
+    }
+}
+
+int main()
+{
+    testAllocate();
+    testRelease();
+    testCapacity();
+    testHeadroom();
+    return Test::getResult("test_packet_pool");
+}
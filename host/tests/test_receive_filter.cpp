@@ -0,0 +1,222 @@
+/**
+ ******************************************************************************
+ * @file    test_receive_filter.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the test of receive filters of ENC28J60
+ *          model: the frames accepted and dropped by unicast, broadcast,
+ *          pattern match and hash table filters in OR and AND modes.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+
+namespace {
+    constexpr uint16_t PORT = 5000;
+
+    constexpr uint16_t OTHER_PORT = 5001;
+
+    constexpr size_t DATA_LEN = 100;
+
+    constexpr uint32_t GROUP_IP = Ethernet::makeIpAddr(239, 1, 2, 3);
+
+    constexpr uint32_t OTHER_GROUP_IP = Ethernet::makeIpAddr(239, 1, 2, 4);
+
+    constexpr uint8_t OTHER_MAC[NetDevice::MAC_ADDR_SIZE] = { 0x02,
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+        0x02 };
+
+    /// Window of pattern: IP header and UDP header with start of data
+    constexpr size_t PATTERN_OFFSET = Ethernet::IP_P;
+
+    /// Bytes of window: protocol of IP and destination port of UDP
+    constexpr size_t PROTOCOL_BYTE = 9;
+    constexpr size_t PORT_BYTE = Ethernet::IpHeader::SIZE + 2;
+
+    /// Byte of UDP data, selected by high half of mask
+    constexpr size_t DATA_BYTE = 40;
+
+    uint8_t frame[Test::MAX_FRAME_SIZE];
+
+    uint8_t received[Test::MAX_FRAME_SIZE];
+
+    /**
+     * @brief Frame is injected, the accepted frame is read out of ring
+     * @retval true - the frame has passed the filters
+     */
+    bool isAccepted(Test::SimBoard& board, size_t len)
+    {
+        if(!board.getSim().inject(frame, len)) {
+            return false;
+        }
+        CHECK(board.getDevice().receive(received, sizeof(received)) == len);
+        return true;
+    }
+
+    /**
+     * @brief UDP datagram of peer
+     * @param [in] dstMac - destination address, nullptr - of IP address
+     * @param [in] dataLen - length of data after UDP header
+     * @retval length of frame
+     */
+    size_t makeDatagram(uint16_t port,
+        const uint8_t* dstMac = nullptr,
+        uint32_t dstIp = Test::BOARD_IP,
+        size_t dataLen = DATA_LEN)
+    {
+        const size_t len =
+            Test::makeUdpDatagram(frame, port, dataLen, 1, dstIp);
+        if(dstMac != nullptr) {
+            memcpy(frame, dstMac, NetDevice::MAC_ADDR_SIZE);
+        }
+        return len;
+    }
+
+    /**
+     * @brief Filters of initialization: unicast and pattern of ARP
+     *        broadcast (see INIT_SCRIPT of driver)
+     */
+    void testDefault(Test::SimBoard& board)
+    {
+        constexpr uint8_t BROADCAST[NetDevice::MAC_ADDR_SIZE] = { 0xFF,
+            0xFF,
+            0xFF,
+            0xFF,
+            0xFF,
+            0xFF };
+
+        CHECK(isAccepted(board, makeDatagram(PORT)));
+        CHECK(isAccepted(board, Test::makeArpRequest(frame)));
+        CHECK(!isAccepted(board, makeDatagram(PORT, BROADCAST)));
+        CHECK(!isAccepted(board, makeDatagram(PORT, OTHER_MAC)));
+        CHECK(!isAccepted(board, makeDatagram(PORT, nullptr, GROUP_IP)));
+
+        board.getDevice().setReceiveFilter(
+            Enc28j60::FILTER_UNICAST | Enc28j60::FILTER_BROADCAST);
+        CHECK(isAccepted(board, makeDatagram(PORT, BROADCAST)));
+        CHECK(isAccepted(board, Test::makeArpRequest(frame)));
+        CHECK(!isAccepted(board, makeDatagram(PORT, OTHER_MAC)));
+
+        // without filters all frames are received
+        board.getDevice().setReceiveFilter(0);
+        CHECK(isAccepted(board, makeDatagram(PORT, OTHER_MAC)));
+        CHECK(isAccepted(board, makeDatagram(PORT, nullptr, GROUP_IP)));
+    }
+
+    /**
+     * @brief Pattern match of bytes selected by mask, the checksum of
+     *        driver is calculated over these bytes only (odd number of
+     *        them and bytes of high half of mask)
+     */
+    void testPattern(Test::SimBoard& board)
+    {
+        Enc28j60& device = board.getDevice();
+        uint8_t pattern[Enc28j60::PATTERN_WINDOW_SIZE];
+        makeDatagram(PORT);
+        memcpy(pattern, &frame[PATTERN_OFFSET], sizeof(pattern));
+
+        const uint64_t one = 1;
+        device.setReceiveFilter(Enc28j60::FILTER_PATTERN);
+        device.setPatternMatch(PATTERN_OFFSET,
+            pattern,
+            sizeof(pattern),
+            (one << PROTOCOL_BYTE) | (one << PORT_BYTE) |
+                (one << (PORT_BYTE + 1)));
+        CHECK(isAccepted(board, makeDatagram(PORT)));
+        CHECK(isAccepted(board, makeDatagram(PORT, OTHER_MAC)));
+        CHECK(!isAccepted(board, makeDatagram(OTHER_PORT)));
+        CHECK(!isAccepted(board, Test::makeEchoRequest(frame, DATA_LEN, 1)));
+
+        // the window must be inside the frame, the CRC ends the window
+        // of datagram of this data length
+        const size_t windowDataLen = PATTERN_OFFSET +
+                                Enc28j60::PATTERN_WINDOW_SIZE -
+                                Ethernet::CRC_SIZE - Ethernet::TRANSPORT_P -
+                                Ethernet::UdpHeader::SIZE;
+        CHECK(!isAccepted(board,
+            makeDatagram(PORT, nullptr, Test::BOARD_IP, windowDataLen - 1)));
+        CHECK(isAccepted(board,
+            makeDatagram(PORT, nullptr, Test::BOARD_IP, windowDataLen)));
+
+        // the byte of data is changed
+        device.setPatternMatch(PATTERN_OFFSET,
+            pattern,
+            sizeof(pattern),
+            (one << (PORT_BYTE + 1)) | (one << DATA_BYTE));
+        CHECK(isAccepted(board, makeDatagram(PORT)));
+        const size_t len = makeDatagram(PORT);
+        ++frame[PATTERN_OFFSET + DATA_BYTE];
+        CHECK(!isAccepted(board, len));
+    }
+
+    /**
+     * @brief All enabled filters must accept frame in AND mode
+     */
+    void testAnd(Test::SimBoard& board)
+    {
+        Enc28j60& device = board.getDevice();
+        device.setReceiveFilter(Enc28j60::FILTER_AND |
+                                Enc28j60::FILTER_UNICAST |
+                                Enc28j60::FILTER_PATTERN);
+        CHECK(isAccepted(board, makeDatagram(PORT)));
+        CHECK(!isAccepted(board, makeDatagram(PORT, OTHER_MAC)));
+        CHECK(!isAccepted(board, makeDatagram(OTHER_PORT)));
+
+        device.setReceiveFilter(
+            Enc28j60::FILTER_UNICAST | Enc28j60::FILTER_PATTERN);
+        CHECK(isAccepted(board, makeDatagram(PORT, OTHER_MAC)));
+        CHECK(isAccepted(board, makeDatagram(OTHER_PORT)));
+    }
+
+    /**
+     * @brief Multicast groups pass hash table filter by bit of their
+     *        address only
+     */
+    void testHash(Test::SimBoard& board)
+    {
+        Enc28j60& device = board.getDevice();
+        uint8_t table[Enc28j60::HASH_TABLE_SIZE];
+        device.setReceiveFilter(Enc28j60::FILTER_UNICAST);
+
+        memset(table, 0xFF, sizeof(table));
+        device.setHashTable(table);
+        CHECK(isAccepted(board, makeDatagram(PORT, nullptr, GROUP_IP)));
+        CHECK(isAccepted(board, makeDatagram(PORT, OTHER_MAC)));
+
+        memset(table, 0, sizeof(table));
+        device.setHashTable(table);
+        CHECK(!isAccepted(board, makeDatagram(PORT, nullptr, GROUP_IP)));
+        CHECK(isAccepted(board, makeDatagram(PORT)));
+
+        uint8_t groupMac[NetDevice::MAC_ADDR_SIZE];
+        makeDatagram(PORT, nullptr, GROUP_IP);
+        memcpy(groupMac, frame, sizeof(groupMac));
+        device.addMulticast(groupMac);
+        CHECK(isAccepted(board, makeDatagram(PORT, nullptr, GROUP_IP)));
+        CHECK(!isAccepted(
+            board, makeDatagram(PORT, nullptr, OTHER_GROUP_IP)));
+
+        device.clearMulticast();
+        CHECK(!isAccepted(board, makeDatagram(PORT, nullptr, GROUP_IP)));
+    }
+}
+
+int main()
+{
+    static Test::SimBoard board;
+    testDefault(board);
+    testPattern(board);
+    testAnd(board);
+    testHash(board);
+    return Test::getResult("test_receive_filter");
+}
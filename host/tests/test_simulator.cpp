@@ -0,0 +1,278 @@
+/**
+ ******************************************************************************
+ * @file    test_simulator.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the test of driver over ENC28J60 model:
+ *          initialization, ARP and echo replies in polled and DMA modes,
+ *          overflow of RX ring. The SPI cost of echo is reported.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+
+namespace {
+    /// Core clock of board for estimate of SPI time
+    constexpr uint32_t CORE_CLOCK = 72000000;
+
+    /// Prescaler of SPI selected by calibration on board
+    constexpr uint32_t PRESCALER = 4;
+
+    constexpr size_t ECHO_ROUNDS = 100;
+
+    /// UDP port without socket (discard service)
+    constexpr uint16_t DISCARD_PORT = 9;
+
+    /// MAC and PHY registers of duplex (bank 2 and PHY address)
+    constexpr uint8_t MAC_BANK = 2;
+    constexpr uint8_t MACON3 = 0x02;
+    constexpr uint8_t MABBIPG = 0x04;
+    constexpr uint8_t MACON3_FULDPX = 0x01;
+    constexpr uint8_t PHCON1 = 0x00;
+    constexpr uint8_t PHSTAT2 = 0x11;
+    constexpr uint16_t PHCON1_PDPXMD = 0x0100;
+    constexpr uint16_t PHSTAT2_DPXSTAT = 0x0200;
+
+    uint8_t request[Test::MAX_FRAME_SIZE];
+
+    uint8_t reply[Test::MAX_FRAME_SIZE];
+
+    /**
+     * @brief Driver is configured by the model as by ENC28J60
+     */
+    void testInit(Test::SimBoard& board)
+    {
+        Enc28j60& device = board.getDevice();
+        CHECK(0 == device.getStatistics().configErrors);
+        CHECK(device.isLinkUp());
+        CHECK(device.selfTest());
+        CHECK(Enc28j60::Duplex::HALF == device.getDuplex());
+        CHECK(!(board.getSim().getRegister(MAC_BANK, MACON3) &
+                MACON3_FULDPX));
+        CHECK(0x12 == board.getSim().getRegister(MAC_BANK, MABBIPG));
+
+        board.getSim().setLink(false);
+        CHECK(!device.isLinkUp());
+        board.getSim().setLink(true);
+    }
+
+    /**
+     * @brief Full duplex is set in MAC and PHY, with back-to-back gap
+     *        of full duplex
+     */
+    void testFullDuplex(Test::SimBoard& board)
+    {
+        Enc28j60Sim& sim = board.getSim();
+        CHECK(0 == board.getDevice().getStatistics().configErrors);
+        CHECK(Enc28j60::Duplex::FULL == board.getDevice().getDuplex());
+        CHECK(sim.getRegister(MAC_BANK, MACON3) & MACON3_FULDPX);
+        CHECK(0x15 == sim.getRegister(MAC_BANK, MABBIPG));
+        CHECK(sim.getPhy(PHCON1) & PHCON1_PDPXMD);
+        CHECK(sim.getPhy(PHSTAT2) & PHSTAT2_DPXSTAT);
+    }
+
+    /**
+     * @brief ARP request of board address is answered
+     */
+    void testArp(Test::SimBoard& board)
+    {
+        Enc28j60Sim& sim = board.getSim();
+        const size_t len = Test::makeArpRequest(request);
+        CHECK(sim.inject(request, len));
+        board.getStack().poll();
+
+        const size_t replyLen = sim.takeSent(reply, sizeof(reply));
+        CHECK(replyLen >= Ethernet::ARP_FRAME_SIZE);
+        const Ethernet::ArpHeader arp(&reply[Ethernet::IP_P]);
+        CHECK(Ethernet::ArpHeader::OPCODE_REPLY == arp.getOpcode());
+        CHECK(0 == memcmp(arp.getSrcMac(),
+                       Test::BOARD_MAC,
+                       NetDevice::MAC_ADDR_SIZE));
+        CHECK(Test::BOARD_IP == arp.getSrcIp());
+        CHECK(Test::PEER_IP == arp.getDstIp());
+    }
+
+    /**
+     * @brief Echo requests up to full frame are answered with the same data
+     * @param [in] name - name of mode for report
+     */
+    void testEcho(Test::SimBoard& board, const char* name)
+    {
+        Enc28j60Sim& sim = board.getSim();
+        Test::Random random;
+        size_t bytes = 0;
+        sim.resetCost();
+        for(size_t round = 0; round < ECHO_ROUNDS; ++round) {
+            const size_t dataLen =
+                (0 == round) ? Test::MAX_ECHO_DATA :
+                               (random.next() % (Test::MAX_ECHO_DATA + 1));
+            const size_t len = Test::makeEchoRequest(request, dataLen, round);
+            CHECK(sim.inject(request, len));
+            board.getStack().poll();
+
+            const size_t replyLen = sim.takeSent(reply, sizeof(reply));
+            CHECK(replyLen == len);
+            CHECK(Ethernet::IcmpHeader::TYPE_ECHO_REPLY ==
+                  reply[Ethernet::TRANSPORT_P]);
+            CHECK(0 == Ethernet::CalcCrc(&reply[Ethernet::IP_P],
+                           Ethernet::IpHeader::SIZE,
+                           Ethernet::PacketType_t::IP));
+            CHECK(0 == Ethernet::CalcCrc(&reply[Ethernet::TRANSPORT_P],
+                           len - Ethernet::TRANSPORT_P,
+                           Ethernet::PacketType_t::IP));
+            CHECK(0 == memcmp(&reply[Ethernet::TRANSPORT_P + 8],
+                           &request[Ethernet::TRANSPORT_P + 8],
+                           dataLen));
+            bytes += len;
+        }
+        CHECK(0 == board.getPool().getStatistics().used);
+
+        const Enc28j60Sim::Cost& cost = sim.getCost();
+        sim.setPrescaler(PRESCALER);
+        printf("%s: %zu echoes of %zu bytes, per echo %u SPI bytes, "
+               "%u transactions, %llu ns at %u MHz / %u\n",
+            name,
+            ECHO_ROUNDS,
+            bytes,
+            static_cast<unsigned>(cost.bytes / ECHO_ROUNDS),
+            static_cast<unsigned>(cost.transactions / ECHO_ROUNDS),
+            static_cast<unsigned long long>(
+                sim.estimateNs(CORE_CLOCK) / ECHO_ROUNDS),
+            static_cast<unsigned>(CORE_CLOCK / 1000000),
+            static_cast<unsigned>(PRESCALER));
+    }
+
+    /**
+     * @brief Frames injected over capacity of RX ring are dropped,
+     *        the driver counts overflow and receives the rest
+     */
+    void testOverflow(Test::SimBoard& board)
+    {
+        Enc28j60Sim& sim = board.getSim();
+        const size_t len =
+            Test::makeEchoRequest(request, Test::MAX_ECHO_DATA, 0);
+        size_t injected = 0;
+        while(sim.inject(request, len)) {
+            ++injected;
+        }
+        CHECK(injected > 0);
+        CHECK(sim.getOverflows() > 0);
+
+        size_t replies = 0;
+        for(size_t i = 0; i < injected; ++i) {
+            board.getStack().poll();
+            while(sim.takeSent(reply, sizeof(reply)) != 0) {
+                ++replies;
+            }
+        }
+        CHECK(replies == injected);
+        CHECK(board.getDevice().getStatistics().rxOverflows > 0);
+
+        // receive goes on after overflow
+        CHECK(sim.inject(request, len));
+        board.getStack().poll();
+        CHECK(sim.takeSent(reply, sizeof(reply)) == len);
+    }
+
+    /**
+     * @brief RX ring filled by short frames: the telemetry of batch holds
+     *        the bytes and packets of full ring, the packet counter does
+     *        not reach its limit before the ring is full
+     */
+    void testRingTelemetry(Test::SimBoard& board)
+    {
+        // receive header, short frame and CRC on even address
+        constexpr size_t FRAME_SPACE = 6 + Test::MIN_FRAME_SIZE + 4;
+
+        Enc28j60Sim& sim = board.getSim();
+        Enc28j60& device = board.getDevice();
+        device.resetTelemetry();
+        const size_t len = Test::makeUdpDatagram(request,
+            DISCARD_PORT,
+            Test::MIN_FRAME_SIZE - Ethernet::TRANSPORT_P -
+                Ethernet::UdpHeader::SIZE,
+            0);
+        CHECK(Test::MIN_FRAME_SIZE == len);
+        size_t injected = 0;
+        while(sim.inject(request, len)) {
+            ++injected;
+        }
+
+        size_t received = 0;
+        while(device.receive(reply, sizeof(reply)) != 0) {
+            ++received;
+        }
+        CHECK(injected == received);
+
+        const Enc28j60::Telemetry& telemetry = device.getTelemetry();
+        CHECK((injected * FRAME_SPACE) == telemetry.rxHighWater);
+        CHECK((telemetry.rxSize - telemetry.rxHighWater) < FRAME_SPACE);
+        CHECK(injected == telemetry.maxPacketCount);
+        CHECK(0 == telemetry.packetCountSaturations);
+
+        device.resetTelemetry();
+        CHECK(0 == telemetry.rxHighWater);
+        CHECK(0 == telemetry.maxPacketCount);
+    }
+
+    /**
+     * @brief Partition of SRAM: TX slots of even size between minimum
+     *        (short frame) and RX ring of at least one full frame
+     */
+    void testPartition(Test::SimBoard& board)
+    {
+        const Enc28j60::Telemetry& telemetry =
+            board.getDevice().getTelemetry();
+        CHECK(Enc28j60::isValidPartition(
+            telemetry.txSlots, telemetry.txSlotSize));
+        CHECK((telemetry.rxSize + telemetry.txSlots * telemetry.txSlotSize) ==
+              0x2000);
+
+        // number of slots from 1 to 4
+        CHECK(!Enc28j60::isValidPartition(0, telemetry.txSlotSize));
+        CHECK(Enc28j60::isValidPartition(4, 0x0600));
+        CHECK(!Enc28j60::isValidPartition(5, 0x0044));
+
+        // even slot, not less than control byte, short frame and status
+        CHECK(Enc28j60::isValidPartition(1, 0x0044));
+        CHECK(!Enc28j60::isValidPartition(1, 0x0042));
+        CHECK(!Enc28j60::isValidPartition(1, 0x0045));
+
+        // RX ring of 0x0600 bytes at least
+        CHECK(Enc28j60::isValidPartition(2, 0x0D00));
+        CHECK(!Enc28j60::isValidPartition(2, 0x0D02));
+        CHECK(!Enc28j60::isValidPartition(1, 0x1A02));
+    }
+}
+
+int main()
+{
+    static Test::SimBoard polled(false);
+    testInit(polled);
+    testArp(polled);
+    testEcho(polled, "polled");
+    testOverflow(polled);
+    testRingTelemetry(polled);
+    testPartition(polled);
+
+    static Test::SimBoard dma(true);
+    testInit(dma);
+    testArp(dma);
+    testEcho(dma, "dma");
+
+    static Test::SimBoard fullDuplex(false,
+        true,
+        0,
+        Enc28j60::Duplex::FULL);
+    testFullDuplex(fullDuplex);
+    testArp(fullDuplex);
+
+    return Test::getResult("test_simulator");
+}
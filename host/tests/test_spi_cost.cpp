@@ -0,0 +1,230 @@
+/**
+ ******************************************************************************
+ * @file    test_spi_cost.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the test of SPI cost of driver over ENC28J60
+ *          model: transactions and bank switches of initialization and
+ *          of ICMP echo, full frames received and sent back by driver
+ *          in polled and DMA modes, the data bursts are moved by DMA,
+ *          not by CPU, and the CPU is not spent on polling of DMA.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+
+namespace {
+    /// Core clock of board for estimate of SPI time
+    constexpr uint32_t CORE_CLOCK = 72000000;
+
+    /// Prescaler of SPI selected by calibration on board
+    constexpr uint32_t PRESCALER = 4;
+
+    constexpr size_t ECHO_ROUNDS = 20;
+
+    /// Bounds of initialization of driver (register script sorted by bank)
+    constexpr uint32_t MAX_INIT_TRANSACTIONS = 100;
+    constexpr uint32_t MAX_INIT_BANK_SWITCHES = 24;
+
+    /// Bounds of ICMP echo (receive, check, reply, release)
+    constexpr uint32_t MAX_ECHO_TRANSACTIONS = 52;
+    constexpr uint32_t MAX_ECHO_BANK_SWITCHES = 2;
+
+    /// SPI bytes of CPU per frame in DMA mode: opcodes, registers and
+    /// heads of frames, not the data
+    constexpr uint32_t MAX_CPU_BYTES = 200;
+
+    uint8_t request[Test::MAX_FRAME_SIZE];
+
+    uint8_t reply[Test::MAX_FRAME_SIZE];
+
+    /**
+     * @brief Cost of initialization: the model counts from its reset
+     *        by constructor of driver
+     * @param [in] name - name of mode for report
+     */
+    void testInit(Test::SimBoard& board, const char* name)
+    {
+        const Enc28j60Sim::Cost& cost = board.getSim().getCost();
+        CHECK(cost.transactions <= MAX_INIT_TRANSACTIONS);
+        CHECK(cost.bankSwitches <= MAX_INIT_BANK_SWITCHES);
+        printf("%s: init %u SPI bytes, %u transactions, "
+               "%u bank switches\n",
+            name,
+            static_cast<unsigned>(cost.bytes),
+            static_cast<unsigned>(cost.transactions),
+            static_cast<unsigned>(cost.bankSwitches));
+    }
+
+    /**
+     * @brief Cost of ICMP echo of random length, the echo data is copied
+     *        inside ENC28J60
+     * @param [in] name - name of mode for report
+     */
+    void testIcmpEcho(Test::SimBoard& board, const char* name)
+    {
+        Enc28j60Sim& sim = board.getSim();
+        Test::Random random;
+        sim.resetCost();
+        for(size_t round = 0; round < ECHO_ROUNDS; ++round) {
+            const size_t dataLen = random.next() % (Test::MAX_ECHO_DATA + 1);
+            const size_t len = Test::makeEchoRequest(request, dataLen, round);
+            CHECK(sim.inject(request, len));
+            board.getStack().poll();
+            CHECK(sim.takeSent(reply, sizeof(reply)) == len);
+        }
+
+        const Enc28j60Sim::Cost& cost = sim.getCost();
+        CHECK((cost.transactions / ECHO_ROUNDS) <= MAX_ECHO_TRANSACTIONS);
+        CHECK((cost.bankSwitches / ECHO_ROUNDS) <= MAX_ECHO_BANK_SWITCHES);
+        printf("%s: per echo %u SPI bytes, %u transactions, "
+               "%u bank switches\n",
+            name,
+            static_cast<unsigned>(cost.bytes / ECHO_ROUNDS),
+            static_cast<unsigned>(cost.transactions / ECHO_ROUNDS),
+            static_cast<unsigned>(cost.bankSwitches / ECHO_ROUNDS));
+    }
+
+    /// SPI traffic of one frame received and sent back
+    struct EchoCost {
+        uint32_t bytes;    ///< All bytes on SPI
+        uint32_t cpuBytes;    ///< Bytes moved by CPU
+    };
+
+    /**
+     * @brief Full frames are received, fetched and sent back by driver
+     * @param [in] name - name of mode for report
+     * @retval SPI traffic per frame
+     */
+    EchoCost testFrameEcho(Test::SimBoard& board, const char* name)
+    {
+        Enc28j60Sim& sim = board.getSim();
+        Enc28j60& device = board.getDevice();
+        sim.resetCost();
+        board.getDma().resetBytes();
+        for(size_t round = 0; round < ECHO_ROUNDS; ++round) {
+            const size_t len =
+                Test::makeEchoRequest(request, Test::MAX_ECHO_DATA, round);
+            CHECK(sim.inject(request, len));
+
+            uint8_t frame[Test::MAX_FRAME_SIZE];
+            CHECK(device.receive(frame, sizeof(frame)) == len);
+            device.fetch(frame);
+            CHECK(0 == memcmp(frame, request, len));
+            device.send(frame, len);
+
+            CHECK(sim.takeSent(reply, sizeof(reply)) == len);
+            CHECK(0 == memcmp(reply, request, len));
+        }
+
+        EchoCost cost;
+        cost.bytes = sim.getCost().bytes / ECHO_ROUNDS;
+        cost.cpuBytes =
+            (sim.getCost().bytes - board.getDma().getBytes()) / ECHO_ROUNDS;
+
+        sim.setPrescaler(PRESCALER);
+        printf("%s: per frame of %zu bytes %u SPI bytes, %u by CPU, "
+               "%llu ns of SPI at %u MHz / %u\n",
+            name,
+            Enc28j60Sim::FRAME_SIZE,
+            static_cast<unsigned>(cost.bytes),
+            static_cast<unsigned>(cost.cpuBytes),
+            static_cast<unsigned long long>(
+                sim.estimateNs(CORE_CLOCK) / ECHO_ROUNDS),
+            static_cast<unsigned>(CORE_CLOCK / 1000000),
+            static_cast<unsigned>(PRESCALER));
+        return cost;
+    }
+
+    /// Idle function of driver runs DMA of model as its interrupt
+    struct IdleState {
+        Enc28j60Sim* sim;
+        Enc28j60SimDma* dma;
+        size_t calls;    ///< Calls of idle function
+        size_t bursts;    ///< Bursts done by idle function
+        size_t unselected;    ///< Bursts without chip select
+    };
+
+    void idle(void* context)
+    {
+        IdleState* state = static_cast<IdleState*>(context);
+        ++state->calls;
+        if(!state->sim->isSelected()) {
+            ++state->unselected;
+        }
+        if(state->dma->run()) {
+            ++state->bursts;
+        }
+    }
+
+    /**
+     * @brief DMA bursts end later, as on interrupt in main loop: the driver
+     *        gives the time to its idle function and does not poll DMA,
+     *        the callback of DMA closes the buffer memory operation
+     */
+    void testIdle()
+    {
+        static Enc28j60Sim sim;
+        static Enc28j60SimDma dma(&sim);
+        static IdleState state = { &sim, &dma, 0, 0, 0 };
+        dma.setDeferred(true);
+
+        SpiInterface::Config interface{ &sim };
+        Enc28j60::Config config;
+        memcpy(config.macAddr, Test::BOARD_MAC, NetDevice::MAC_ADDR_SIZE);
+        config.dma = &dma;
+        config.idle = &idle;
+        config.idleContext = &state;
+        static Enc28j60 device(&interface, &config);
+
+        const size_t len =
+            Test::makeEchoRequest(request, Test::MAX_ECHO_DATA, 0);
+        CHECK(sim.inject(request, len));
+        const size_t bursts = state.bursts;
+        uint8_t frame[Test::MAX_FRAME_SIZE];
+        CHECK(device.receive(frame, sizeof(frame)) == len);
+        device.fetch(frame);
+        device.send(frame, len);
+        CHECK(sim.takeSent(reply, sizeof(reply)) == len);
+        CHECK(0 == memcmp(reply, request, len));
+
+        // head and rest of received frame, sent frame
+        CHECK((bursts + 3) == state.bursts);
+        CHECK(state.calls == state.bursts);
+        CHECK(0 == state.unselected);
+        CHECK(0 == dma.getBusyPolls());
+        CHECK(!sim.isSelected());
+    }
+}
+
+int main()
+{
+    static Test::SimBoard polled(false);
+    static Test::SimBoard dma(true);
+    testInit(polled, "polled");
+    testInit(dma, "dma");
+    testIcmpEcho(polled, "polled");
+    testIcmpEcho(dma, "dma");
+
+    const EchoCost polledCost = testFrameEcho(polled, "polled");
+    const EchoCost dmaCost = testFrameEcho(dma, "dma");
+
+    // the same traffic on wire, the data of both directions is moved
+    // by DMA
+    CHECK(polledCost.bytes == dmaCost.bytes);
+    CHECK(polledCost.cpuBytes == polledCost.bytes);
+    CHECK(dmaCost.cpuBytes <= MAX_CPU_BYTES);
+    CHECK((dmaCost.bytes - dmaCost.cpuBytes) >=
+          (2 * Test::MAX_ECHO_DATA));
+
+    testIdle();
+
+    return Test::getResult("test_spi_cost");
+}
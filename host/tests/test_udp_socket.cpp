@@ -0,0 +1,162 @@
+/**
+ ******************************************************************************
+ * @file    test_udp_socket.cpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the test of UDP sockets over ENC28J60 model:
+ *          binding of ports by several sockets and delivery of datagrams
+ *          of multicast group.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "test_utils.hpp"
+#include "ethernet/udp_socket.hpp"
+
+namespace {
+    constexpr uint16_t PORT = 5000;
+
+    constexpr uint16_t OTHER_PORT = 5001;
+
+    constexpr size_t DATA_LEN = 100;
+
+    constexpr uint32_t GROUP_IP = Ethernet::makeIpAddr(239, 1, 2, 3);
+
+    uint8_t request[Test::MAX_FRAME_SIZE];
+
+    /**
+     * @brief Receiver counts received datagrams
+     */
+    class CountReceiver final : public UdpReceiver {
+      public:
+        CountReceiver() : _count(0) {}
+
+        void receive(UdpSocket*,
+            const UdpEndpoint&,
+            const uint8_t*,
+            size_t) override
+        {
+            ++_count;
+        }
+
+        size_t getCount() const
+        {
+            return _count;
+        }
+
+      private:
+        size_t _count;
+    };
+
+    /**
+     * @brief Datagram of peer to port is injected and processed
+     * @param [in] dstIp - destination address, board or multicast group
+     */
+    void receive(Test::SimBoard& board,
+        uint16_t port,
+        uint32_t dstIp = Test::BOARD_IP)
+    {
+        const size_t len =
+            Test::makeUdpDatagram(request, port, DATA_LEN, 1, dstIp);
+        CHECK(board.getSim().inject(request, len));
+        board.getStack().poll();
+    }
+
+    /**
+     * @brief The port bound by socket is not taken over by other socket,
+     *        close of socket does not unregister other owner of its port
+     */
+    void testBind(Test::SimBoard& board)
+    {
+        CountReceiver firstReceiver;
+        CountReceiver secondReceiver;
+        UdpSocket first(&board.getStack(), &firstReceiver);
+        UdpSocket second(&board.getStack(), &secondReceiver);
+
+        CHECK(first.bind(PORT));
+        CHECK(first.bind(PORT));
+        CHECK(!second.bind(PORT));
+        CHECK(0 == second.getPort());
+        CHECK(!second.bind(0));
+
+        // the failed bind does not change the bound socket
+        CHECK(second.bind(OTHER_PORT));
+        CHECK(!second.bind(PORT));
+        CHECK(OTHER_PORT == second.getPort());
+        receive(board, PORT);
+        receive(board, OTHER_PORT);
+        CHECK(1 == firstReceiver.getCount());
+        CHECK(1 == secondReceiver.getCount());
+
+        // the port is free after close
+        first.close();
+        CHECK(0 == first.getPort());
+        CHECK(second.bind(PORT));
+        CHECK(nullptr ==
+              board.getStack().getHandler(Ethernet::Protocol::UDP,
+                  OTHER_PORT));
+        receive(board, PORT);
+        CHECK(1 == firstReceiver.getCount());
+        CHECK(2 == secondReceiver.getCount());
+
+        // the port registered again by other handler stays registered
+        board.getStack().addHandler(Ethernet::Protocol::UDP, PORT, &first);
+        second.close();
+        CHECK(&first ==
+              board.getStack().getHandler(Ethernet::Protocol::UDP, PORT));
+        board.getStack().removeHandler(Ethernet::Protocol::UDP, PORT);
+    }
+
+    /**
+     * @brief Datagram of multicast group is received by socket of its
+     *        port, the other protocols of group are not processed
+     */
+    void testMulticast(Test::SimBoard& board)
+    {
+        CountReceiver receiver;
+        UdpSocket socket(&board.getStack(), &receiver);
+        CHECK(socket.bind(PORT));
+
+        uint8_t groupMac[NetDevice::MAC_ADDR_SIZE];
+        const size_t len =
+            Test::makeUdpDatagram(request, PORT, DATA_LEN, 1, GROUP_IP);
+        memcpy(groupMac, request, NetDevice::MAC_ADDR_SIZE);
+        board.getDevice().addMulticast(groupMac);
+
+        CHECK(board.getSim().inject(request, len));
+        board.getStack().poll();
+        CHECK(1 == receiver.getCount());
+        CHECK(1 == socket.getStatistics().received);
+        receive(board, OTHER_PORT, GROUP_IP);
+        CHECK(1 == receiver.getCount());
+
+        // echo request of group is not answered
+        uint8_t reply[Test::MAX_FRAME_SIZE];
+        const size_t echoLen = Test::makeEchoRequest(request, DATA_LEN, 1);
+        Ethernet::IpHeader ip(&request[Ethernet::IP_P]);
+        ip.setDstIp(GROUP_IP);
+        ip.setChecksum(0);
+        ip.setChecksum(Ethernet::CalcCrc(&request[Ethernet::IP_P],
+            Ethernet::IpHeader::SIZE,
+            Ethernet::PacketType_t::IP));
+        CHECK(board.getSim().inject(request, echoLen));
+        board.getStack().poll();
+        CHECK(0 == board.getSim().takeSent(reply, sizeof(reply)));
+
+        board.getDevice().clearMulticast();
+    }
+}
+
+int main()
+{
+    static Test::SimBoard board;
+    testBind(board);
+    testMulticast(board);
+    return Test::getResult("test_udp_socket");
+}
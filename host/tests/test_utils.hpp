@@ -0,0 +1,305 @@
+/**
+ ******************************************************************************
+ * @file    test_utils.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the helpers of host tests: checks, frames
+ *          of remote host and the board of ENC28J60 model.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TEST_UTILS_HPP
+#define __TEST_UTILS_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "utils/spi_interface.hpp"
+#include "ethernet/enc28j60.hpp"
+#include "ethernet/net_stack.hpp"
+#include "ethernet/packet_pool.hpp"
+
+/// Check of test, the failure is printed and counted
+#define CHECK(condition)                                               \
+    do {                                                               \
+        if(!(condition)) {                                             \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            ++Test::getFailures();                                     \
+        }                                                              \
+    } while(0)
+
+namespace Test {
+    /// Exit code of skipped test (see SKIP_RETURN_CODE of CMake)
+    constexpr int SKIPPED = 77;
+
+    constexpr uint8_t BOARD_MAC[NetDevice::MAC_ADDR_SIZE] = { 0x00,
+        0x2F,
+        0x68,
+        0x12,
+        0xAC,
+        0x30 };
+
+    constexpr uint8_t PEER_MAC[NetDevice::MAC_ADDR_SIZE] = { 0x02,
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+        0x01 };
+
+    constexpr uint32_t BOARD_IP = Ethernet::makeIpAddr(192, 168, 0, 200);
+
+    constexpr uint32_t PEER_IP = Ethernet::makeIpAddr(192, 168, 0, 1);
+
+    /// Minimum ethernet frame without CRC
+    constexpr size_t MIN_FRAME_SIZE = 60;
+
+    inline unsigned& getFailures()
+    {
+        static unsigned failures = 0;
+        return failures;
+    }
+
+    /**
+     * @brief Exit code of test
+     * @param [in] name - name of test
+     */
+    inline int getResult(const char* name)
+    {
+        printf("%s: %s\n", name, (0 == getFailures()) ? "passed" : "FAILED");
+        return (0 == getFailures()) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /**
+     * @brief Pseudo-random numbers of tests (xorshift32), the sequence
+     *        is repeated on each run
+     */
+    class Random {
+      public:
+        explicit Random(uint32_t seed = 0x12345678) : _state(seed) {}
+
+        uint32_t next()
+        {
+            _state ^= _state << 13;
+            _state ^= _state >> 17;
+            _state ^= _state << 5;
+            return _state;
+        }
+
+      private:
+        uint32_t _state;
+    };
+
+    /// Buffer of frame, the driver reads at most one byte less than buffer
+    constexpr size_t MAX_FRAME_SIZE = Enc28j60Sim::FRAME_SIZE + 4;
+
+    /// Maximum data of echo request in one frame
+    constexpr size_t MAX_ECHO_DATA = Enc28j60Sim::FRAME_SIZE -
+                                     Ethernet::TRANSPORT_P -
+                                     Ethernet::IcmpHeader::SIZE;
+
+    /**
+     * @brief ARP request of peer for address of board
+     * @param [in] frame - buffer of frame
+     * @retval length of frame
+     */
+    inline size_t makeArpRequest(uint8_t* frame)
+    {
+        using namespace Ethernet;
+        EthHeader eth(frame);
+        memset(eth.getDstMac(), 0xFF, NetDevice::MAC_ADDR_SIZE);
+        memcpy(eth.getSrcMac(), PEER_MAC, NetDevice::MAC_ADDR_SIZE);
+        eth.setType(EthHeader::TYPE_ARP);
+
+        ArpHeader arp(&frame[IP_P]);
+        const uint8_t fixed[] = { 0x00, 0x01, 0x08, 0x00, 0x06, 0x04 };
+        memcpy(arp.data(), fixed, sizeof(fixed));
+        arp.setOpcode(ArpHeader::OPCODE_REQUEST);
+        memcpy(arp.getSrcMac(), PEER_MAC, NetDevice::MAC_ADDR_SIZE);
+        arp.setSrcIp(PEER_IP);
+        memset(arp.getDstMac(), 0, NetDevice::MAC_ADDR_SIZE);
+        arp.setDstIp(BOARD_IP);
+        // the peer pads the frame to minimum size of ethernet
+        memset(&frame[ARP_FRAME_SIZE], 0, MIN_FRAME_SIZE - ARP_FRAME_SIZE);
+        return MIN_FRAME_SIZE;
+    }
+
+    /**
+     * @brief Echo request of peer to board
+     * @param [in] frame - buffer of frame
+     * @param [in] dataLen - length of data after ICMP header
+     * @param [in] seed - first byte of data pattern
+     * @retval length of frame
+     */
+    inline size_t makeEchoRequest(uint8_t* frame, size_t dataLen, uint8_t seed)
+    {
+        using namespace Ethernet;
+        const size_t icmpLen = IcmpHeader::SIZE + dataLen;
+        MakeIpFrame(frame,
+            BOARD_MAC,
+            PEER_MAC,
+            BOARD_IP,
+            PEER_IP,
+            IpHeader::PROTOCOL_ICMP,
+            IpHeader::SIZE + icmpLen,
+            seed);
+
+        uint8_t* icmp = &frame[TRANSPORT_P];
+        memset(icmp, 0, IcmpHeader::SIZE);
+        icmp[0] = IcmpHeader::TYPE_ECHO_REQUEST;
+        for(size_t i = 0; i < dataLen; ++i) {
+            icmp[IcmpHeader::SIZE + i] = static_cast<uint8_t>(seed + i * 7);
+        }
+        const uint16_t sum = CalcCrc(icmp, icmpLen, PacketType_t::IP);
+        icmp[2] = sum >> 8;
+        icmp[3] = sum & 0xFF;
+        return TRANSPORT_P + icmpLen;
+    }
+
+    /**
+     * @brief UDP datagram of peer to board
+     * @param [in] frame - buffer of frame
+     * @param [in] port - destination port
+     * @param [in] dataLen - length of data after UDP header
+     * @param [in] seed - first byte of data pattern
+     * @param [in] dstIp - destination address, board or multicast group
+     *             (its MAC address is mapped from group)
+     * @retval length of frame
+     */
+    inline size_t makeUdpDatagram(uint8_t* frame,
+        uint16_t port,
+        size_t dataLen,
+        uint8_t seed,
+        uint32_t dstIp = BOARD_IP)
+    {
+        using namespace Ethernet;
+        uint8_t dstMac[NetDevice::MAC_ADDR_SIZE];
+        memcpy(dstMac, BOARD_MAC, NetDevice::MAC_ADDR_SIZE);
+        if(isMulticastIp(dstIp)) {
+            // 01:00:5E and low 23 bits of group (RFC 1112)
+            const uint8_t group[] = { 0x01,
+                0x00,
+                0x5E,
+                static_cast<uint8_t>((dstIp >> 16) & 0x7F),
+                static_cast<uint8_t>(dstIp >> 8),
+                static_cast<uint8_t>(dstIp) };
+            memcpy(dstMac, group, NetDevice::MAC_ADDR_SIZE);
+        }
+
+        const size_t udpLen = UdpHeader::SIZE + dataLen;
+        MakeIpFrame(frame,
+            dstMac,
+            PEER_MAC,
+            dstIp,
+            PEER_IP,
+            IpHeader::PROTOCOL_UDP,
+            IpHeader::SIZE + udpLen,
+            seed);
+
+        UdpHeader udp(&frame[TRANSPORT_P]);
+        udp.setSrcPort(port);
+        udp.setDstPort(port);
+        udp.setLen(udpLen);
+        udp.setChecksum(0);
+        for(size_t i = 0; i < dataLen; ++i) {
+            frame[TRANSPORT_P + UdpHeader::SIZE + i] =
+                static_cast<uint8_t>(seed + i * 7);
+        }
+        const uint16_t checksum =
+            CalcTransportChecksum(frame, udpLen, PacketType_t::UDP);
+        // zero means that sender has not computed checksum
+        udp.setChecksum((0 == checksum) ? 0xFFFF : checksum);
+        return TRANSPORT_P + udpLen;
+    }
+
+    /**
+     * @brief Board of tests: ENC28J60 model, its driver (polled or DMA
+     *        bursts) and protocol stack. The model is big, so the board
+     *        is placed statically.
+     */
+    class SimBoard {
+      public:
+        explicit SimBoard(bool isDma = false,
+            bool isChecksumOffload = true,
+            uint16_t tcpPort = 0,
+            Enc28j60::Duplex duplex = Enc28j60::Duplex::HALF) :
+            _dma(&_sim),
+            _interface{ &_sim },
+            _net(&_interface,
+                getDeviceConfig(isDma, isChecksumOffload, duplex)),
+            _stack(&_net, &_pool, getStackConfig(tcpPort))
+        {
+        }
+
+        Enc28j60Sim& getSim()
+        {
+            return _sim;
+        }
+
+        Enc28j60SimDma& getDma()
+        {
+            return _dma;
+        }
+
+        Enc28j60& getDevice()
+        {
+            return _net;
+        }
+
+        PacketPool& getPool()
+        {
+            return _pool;
+        }
+
+        NetStack& getStack()
+        {
+            return _stack;
+        }
+
+      private:
+        const Enc28j60::Config* getDeviceConfig(bool isDma,
+            bool isChecksumOffload,
+            Enc28j60::Duplex duplex)
+        {
+            memcpy(_deviceConfig.macAddr, BOARD_MAC, NetDevice::MAC_ADDR_SIZE);
+            _deviceConfig.dma = isDma ? &_dma : nullptr;
+            _deviceConfig.checksumOffload = isChecksumOffload;
+            _deviceConfig.duplex = duplex;
+            return &_deviceConfig;
+        }
+
+        const NetStack::Config* getStackConfig(uint16_t tcpPort)
+        {
+            _stackConfig.ipAddr = BOARD_IP;
+            _stackConfig.tcpPort = tcpPort;
+            return &_stackConfig;
+        }
+
+        Enc28j60Sim _sim;
+
+        Enc28j60SimDma _dma;
+
+        SpiInterface::Config _interface;
+
+        Enc28j60::Config _deviceConfig;
+
+        Enc28j60 _net;
+
+        StaticPacketPool<> _pool;
+
+        NetStack::Config _stackConfig;
+
+        NetStack _stack;
+    };
+};    // namespace Test
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ ******************************************************************************
+ * @file    non_copyable.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the base of classes without copy for host
+ *          build: the same API as utils/non_copyable.hpp of the MCU library.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NON_COPYABLE_HPP
+#define __NON_COPYABLE_HPP
+
+/**
+ * @brief Private base of class which must not be copied
+ * @tparam T - derived class
+ */
+template<class T>
+class NonCopyable {
+  public:
+    NonCopyable(const NonCopyable&) = delete;
+
+    NonCopyable& operator=(const NonCopyable&) = delete;
+
+  protected:
+    NonCopyable() = default;
+
+    ~NonCopyable() = default;
+};
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ ******************************************************************************
+ * @file    non_movable.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the base of classes without move for host
+ *          build: the same API as utils/non_movable.hpp of the MCU library.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NON_MOVABLE_HPP
+#define __NON_MOVABLE_HPP
+
+/**
+ * @brief Private base of class which must not be moved
+ * @tparam T - derived class
+ */
+template<class T>
+class NonMovable {
+  public:
+    NonMovable(NonMovable&&) = delete;
+
+    NonMovable& operator=(NonMovable&&) = delete;
+
+  protected:
+    NonMovable() = default;
+
+    ~NonMovable() = default;
+};
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ * @file    spi_interface.hpp
+ * @author  Ivan Orfanidi
+ * @version V1.0.0
+ * @date    07/01/2019
+ * @brief   This file provides the SPI interface of ENC28J60 for host build:
+ *          the same API as utils/spi_interface.hpp of the MCU library,
+ *          the bytes go to the ENC28J60 model. The host directory is
+ *          put before the library in the include path.
+ ******************************************************************************
+ * @attention
+ *
+ *
+ * <h2><center>&copy; </center></h2>
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPI_INTERFACE_HPP
+#define __SPI_INTERFACE_HPP
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "enc28j60_sim.hpp"
+
+/**
+ * @brief Observer of interrupt pin
+ */
+class SubjectObserver {
+  public:
+    virtual ~SubjectObserver() = default;
+
+    virtual void update() = 0;
+};
+
+/**
+ * @brief Class of SPI interface over ENC28J60 model
+ */
+class SpiInterface {
+  public:
+    struct Config {
+        Enc28j60Sim* sim;
+    };
+
+    explicit SpiInterface(const Config* config) : _sim(config->sim) {}
+
+    void setSelect(bool isSelect)
+    {
+        _sim->select(isSelect);
+    }
+
+    void sendByte(uint8_t data)
+    {
+        _sim->transfer(data);
+    }
+
+    uint8_t getByte()
+    {
+        return _sim->transfer(0xFF);
+    }
+
+    void delayUs(uint32_t)
+    {
+    }
+
+    void attach(SubjectObserver* observer)
+    {
+        _sim->attach(observer);
+    }
+
+  private:
+    Enc28j60Sim* const _sim;
+};
+
+#endif
@@ -14,19 +14,77 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.hpp"
 
+namespace {
+    /// Status page of board, its headers and checksums are built by compiler
+    constexpr auto STATUS_PAGE = makeHttpResponse("200 OK",
+        "text/html",
+        "<html><head><title>Ethernet</title></head><body>"
+        "<h1>STM32F10x + ENC28J60</h1><p>Online</p></body></html>\n");
+
+    constexpr HttpResource HTTP_RESOURCES[] = { { "/", STATUS_PAGE } };
+}
+
 int main()
 {
-    Main();
+    Main app;
+    app.run();
 }
 
-Main::Main() : _systick(Systick::getInstance()), _lcd(4, 20), _net(nullptr)
+Main::Main() :
+    _systick(Systick::getInstance()),
+    _lcd(4, 20),
+    _net(nullptr),
+    _http(nullptr),
+    _milliseconds(0),
+    _spiClock(0)
 {
     // Configure 1 tick - 1 msec
     _systick.init(SystemCoreClock, 1000);
 
+    // Seed of TCP initial sequence
+    CycleCounter::enable();
+
     initNet();
 }
 
+/**
+ * @brief Main loop, the packets are processed here, not in interrupt
+ */
+void Main::run()
+{
+    while(true) {
+        _net->poll();
+        _http->tick(getMilliseconds());
+    }
+}
+
+/**
+ * @brief Time of TCP timers, counted by 1 ms Systick: each reload of its
+ *        counter sets COUNTFLAG, the flag is cleared on read. The reloads
+ *        are counted in main loop and while bursts of DMA run (see
+ *        updateClock()), the bursts of full frames take longer than
+ *        a tick on slow SPI clock.
+ * @retval time in milliseconds, it wraps around
+ */
+uint32_t Main::getMilliseconds()
+{
+    updateClock(this);
+    return _milliseconds;
+}
+
+/**
+ * @brief Count the reload of Systick, called also by ENC28J60 driver
+ *        while it waits for end of DMA burst
+ * @param [in] context - pointer on Main
+ */
+void Main::updateClock(void* context)
+{
+    Main* const app = static_cast<Main*>(context);
+    if(SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+        ++app->_milliseconds;
+    }
+}
+
 void Main::initNet()
 {
     // Create SPI interface class
@@ -55,13 +113,94 @@ void Main::initNet()
     interface.csPort = GPIOC;
     interface.csPin = 4;
 
-    Enc28j60::Config config;
-    constexpr uint8_t MAC[] = { 0x00, 0x2F, 0x68, 0x12, 0xAC, 0x30 };
-    memcpy(config.macAddr, MAC, Enc28j60::MAC_ADDR_SIZE);
-    constexpr uint8_t IP[] = { 192, 168, 0, 200 };
-    memcpy(config.ipAddr, IP, Enc28j60::IP_ADDR_SIZE);
-    config.tcpPort = 80;
+    // Create ENC28J60, frame buffers and protocol stack without heap,
+    // frame bursts over DMA channels of SPI1
+    static BoardNet net(&interface,
+        SpiDma::getInstance(SPI1),
+        &Main::updateClock,
+        this);
+    _net = &net;
+
+    calibrateSpi(spi, &spiConfig);
 
-    // Create NET class
-    Enc28j60* _net = new Enc28j60(&interface, &config);
+    // HTTP server of status pages on TCP port of configuration
+    static HttpServer http(&net.getStack(),
+        HTTP_RESOURCES,
+        sizeof(HTTP_RESOURCES) / sizeof(HTTP_RESOURCES[0]));
+    http.listen();
+    _http = &http;
+}
+
+/**
+ * @brief Select the fastest reliable SPI clock of ENC28J60. The prescaler
+ *        is stepped from the initial one to faster ones while self test of
+ *        ENC28J60 passes, then one step back is taken as safety margin.
+ *        ENC28J60 is configured again on the selected clock.
+ * @param [in] spi - SPI port of ENC28J60
+ * @param [in] spiConfig - configuration of SPI, initial prescaler is _64P
+ */
+void Main::calibrateSpi(Spi* spi, Spi::Config* spiConfig)
+{
+    struct Step {
+        Spi::Prescaler prescaler;
+        uint32_t divider;
+    };
+    static const Step STEPS[] = { { Spi::Prescaler::_64P, 64 },
+        { Spi::Prescaler::_32P, 32 },
+        { Spi::Prescaler::_16P, 16 },
+        { Spi::Prescaler::_8P, 8 },
+        { Spi::Prescaler::_4P, 4 },
+        { Spi::Prescaler::_2P, 2 } };
+    constexpr size_t STEPS_SIZE = sizeof(STEPS) / sizeof(STEPS[0]);
+
+    size_t passed = 0;
+    for(size_t i = 1; i < STEPS_SIZE; ++i) {
+        // not faster than maximum clock of ENC28J60
+        if((SystemCoreClock / STEPS[i].divider) > ENC28J60_MAX_SPI_CLOCK) {
+            break;
+        }
+        spiConfig->prescaler = STEPS[i].prescaler;
+        spi->init(spiConfig);
+        if(!testNet()) {
+            break;
+        }
+        passed = i;
+    }
+
+    size_t selected = (passed > 0) ? (passed - 1) : 0;
+    spiConfig->prescaler = STEPS[selected].prescaler;
+    spi->init(spiConfig);
+    if(!testNet()) {
+        selected = 0;
+        spiConfig->prescaler = STEPS[selected].prescaler;
+        spi->init(spiConfig);
+    }
+
+    _spiClock = SystemCoreClock / STEPS[selected].divider;
+
+    // the tests on failed clocks may corrupt registers of ENC28J60
+    _net->getDevice().reset();
+}
+
+/**
+ * @brief Repeated self test of ENC28J60 on current SPI clock
+ * @retval true - all rounds passed
+ */
+bool Main::testNet()
+{
+    for(size_t i = 0; i < CALIBRATION_ROUNDS; ++i) {
+        if(!_net->getDevice().selfTest()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Selected SPI clock of ENC28J60
+ * @retval clock in Hz
+ */
+uint32_t Main::getSpiClock() const
+{
+    return _spiClock;
 }
\ No newline at end of file
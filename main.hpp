@@ -26,6 +26,9 @@
 /* Driver lib */
 #include "spi.hpp"
 #include "ethernet/enc28j60.hpp"
+#include "ethernet/spi_dma.hpp"
+#include "ethernet/static_net.hpp"
+#include "ethernet/http_server.hpp"
 #include "hd44780/hd44780.hpp"
 #include "exti.hpp"
 #include "gpio.hpp"
@@ -34,15 +37,44 @@
 
 class Main {
   public:
+    /// Network interface of board: MAC, IP and TCP port of server
+    typedef StaticNet<NetConfig<0x002F6812AC30,
+        Ethernet::makeIpAddr(192, 168, 0, 200),
+        80>>
+        BoardNet;
+
     Main();
 
+    void run();
+
+    uint32_t getSpiClock() const;
+
   private:
+    /// Maximum SPI clock of ENC28J60 (see datasheet)
+    static constexpr uint32_t ENC28J60_MAX_SPI_CLOCK = 20000000;
+
+    /// Self tests on each SPI clock of calibration
+    static constexpr size_t CALIBRATION_ROUNDS = 16;
+
     void initNet();
 
+    uint32_t getMilliseconds();
+
+    static void updateClock(void*);
+
+    void calibrateSpi(Spi*, Spi::Config*);
+
+    bool testNet();
+
     // Drivers interface
     Systick& _systick;
     Hd44780 _lcd;
-    Enc28j60* _net;
+    BoardNet* _net;
+    HttpServer* _http;
+
+    uint32_t _milliseconds;    ///< Time of TCP timers
+
+    uint32_t _spiClock;    ///< Selected SPI clock of ENC28J60
 };
 
 extern "C" {